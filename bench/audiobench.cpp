@@ -0,0 +1,327 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/*
+ * Micro-benchmarks for the file outputs, run with "make bench".
+ *
+ * Each case is driven with a synthetic buffer and repeated for a
+ * minimum amount of time. Files are written to the null device so
+ * only the formatting and the write path are measured.
+ *
+ * Usage: audiobench [--time=<secs>] [case prefix...]
+ *
+ * Results are printed as a JSON array, one case per line, with the
+ * fields always in the same order.
+ */
+
+#include "audio/AudioConfig.h"
+#include "audio/SampleConvert.h"
+#include "audio/au/auFile.h"
+#include "audio/wav/WavFile.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+#ifdef _WIN32
+#  define NULL_DEVICE "NUL"
+#else
+#  define NULL_DEVICE "/dev/null"
+#endif
+
+namespace
+{
+
+// Samples per conversion call, about what the player hands over
+const size_t CHUNK = 4096;
+
+struct case_t
+{
+    const char *name;
+    // Runs one operation and returns the bytes it produced
+    std::function<uint_least64_t()> run;
+};
+
+struct result_t
+{
+    uint_least64_t iterations;
+    uint_least64_t bytes;
+    double         seconds;
+};
+
+// Something that looks like audio and defeats shortcuts on zeros
+void fill(short *buffer, size_t count)
+{
+    uint_least32_t seed = 0x12345678;
+    for (size_t i = 0; i < count; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        buffer[i] = (short)(seed >> 16);
+    }
+}
+
+result_t measure(const case_t &c, double minTime)
+{
+    typedef std::chrono::steady_clock clock;
+
+    // Warm up caches, allocations and the kernel selection
+    c.run();
+
+    result_t result = { 0, 0, 0. };
+    uint_least64_t batch = 1;
+    const auto start = clock::now();
+    for (;;)
+    {
+        for (uint_least64_t i = 0; i < batch; i++)
+            result.bytes += c.run();
+        result.iterations += batch;
+
+        const std::chrono::duration<double> elapsed = clock::now() - start;
+        result.seconds = elapsed.count();
+        if (result.seconds >= minTime)
+            break;
+
+        // Check the clock less often for quick cases
+        if (result.seconds < minTime / 100.)
+            batch *= 2;
+    }
+    return result;
+}
+
+AudioConfig config(int precision)
+{
+    AudioConfig cfg;
+    cfg.frequency = 48000;
+    cfg.channels  = 2;
+    cfg.precision = precision;
+    return cfg;
+}
+
+/*
+ * Write path: one buffer of the size requested by the file,
+ * a second of audio, per operation.
+ */
+template<class T>
+class fileCase
+{
+private:
+    std::shared_ptr<T> file;
+    uint_least32_t size;
+    int bytes;
+
+public:
+    fileCase(int precision) :
+        file(std::make_shared<T>(NULL_DEVICE)),
+        bytes(precision / 8)
+    {
+        AudioConfig cfg = config(precision);
+        if (!file->open(cfg))
+        {
+            cerr << "audiobench: " << file->getErrorString() << endl;
+            exit(EXIT_FAILURE);
+        }
+        size = cfg.bufSize;
+        fill(file->buffer(), size);
+    }
+
+    uint_least64_t operator()()
+    {
+        if (!file->write(size))
+        {
+            cerr << "audiobench: " << file->getErrorString() << endl;
+            exit(EXIT_FAILURE);
+        }
+        return (uint_least64_t)size * bytes;
+    }
+};
+
+/*
+ * Header writing: a whole file without samples,
+ * open, header, length fix up and close.
+ */
+template<class T>
+uint_least64_t headerCase()
+{
+    T file(NULL_DEVICE);
+    AudioConfig cfg = config(16);
+    if (!file.open(cfg))
+        return 0;
+    file.write(0);
+    file.close();
+    return 0;
+}
+
+typedef const void *(*convert_t)(const short *src, void *scratch, size_t count);
+
+class convertCase
+{
+private:
+    std::shared_ptr<std::vector<short>> samples;
+    std::shared_ptr<std::vector<char>> scratch;
+    convert_t convert;
+    int bytes;
+
+public:
+    convertCase(convert_t convert, int bytes) :
+        samples(std::make_shared<std::vector<short>>(CHUNK)),
+        scratch(std::make_shared<std::vector<char>>(sampleConvert::scratchSize(CHUNK))),
+        convert(convert),
+        bytes(bytes)
+    {
+        fill(samples->data(), CHUNK);
+    }
+
+    uint_least64_t operator()()
+    {
+        const void *out = convert(samples->data(), scratch->data(), CHUNK);
+
+        // Native order comes back untouched, copy it like the
+        // other cases so the figures compare
+        if (out == samples->data())
+        {
+            memcpy(scratch->data(), out, CHUNK * bytes);
+            out = scratch->data();
+        }
+
+        // Read the whole result so none of it can be left out
+        uint_least64_t sum = 0;
+        const size_t words = CHUNK * bytes / sizeof(uint_least64_t);
+        for (size_t i = 0; i < words; i++)
+        {
+            uint_least64_t word;
+            memcpy(&word, static_cast<const char*>(out) + i * sizeof(word), sizeof(word));
+            sum ^= word;
+        }
+        volatile uint_least64_t sink = sum;
+        (void)sink;
+        return CHUNK * bytes;
+    }
+};
+
+// Buffer sizing over the usual configurations
+uint_least64_t bytesPerMillisCase()
+{
+    static const uint_least32_t frequencies[] = { 22050, 44100, 48000, 96000 };
+    volatile uint_least32_t sink = 0;
+    AudioConfig cfg;
+    for (const uint_least32_t frequency : frequencies)
+        for (int channels = 1; channels <= 2; channels++)
+            for (int precision = 16; precision <= 32; precision += 16)
+            {
+                cfg.frequency = frequency;
+                cfg.channels  = channels;
+                cfg.precision = precision;
+                sink = sink + cfg.bytesPerMillis();
+            }
+    return 0;
+}
+
+bool selected(const char *name, const std::vector<const char*> &prefixes)
+{
+    if (prefixes.empty())
+        return true;
+
+    for (const char *prefix : prefixes)
+    {
+        if (strncmp(name, prefix, strlen(prefix)) == 0)
+            return true;
+    }
+    return false;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    double minTime = 0.5;
+    std::vector<const char*> prefixes;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--time=", 7) == 0)
+        {
+            minTime = atof(argv[i] + 7);
+            if (minTime <= 0.)
+            {
+                cerr << "audiobench: invalid time " << argv[i] + 7 << endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (argv[i][0] == '-')
+        {
+            cerr << "Usage: " << argv[0] << " [--time=<secs>] [case prefix...]" << endl;
+            return EXIT_FAILURE;
+        }
+        else
+            prefixes.push_back(argv[i]);
+    }
+
+    const case_t cases[] =
+    {
+        { "wav.write.s16",       fileCase<WavFile>(16) },
+        { "wav.write.f32",       fileCase<WavFile>(32) },
+        { "wav.header",          headerCase<WavFile> },
+        { "au.write.s16",        fileCase<auFile>(16) },
+        { "au.write.f32",        fileCase<auFile>(32) },
+        { "au.header",           headerCase<auFile> },
+        { "convert.s16le",       convertCase(sampleConvert::toS16LE, 2) },
+        { "convert.s16be",       convertCase(sampleConvert::toS16BE, 2) },
+        { "convert.f32le",       convertCase(sampleConvert::toF32LE, 4) },
+        { "convert.f32be",       convertCase(sampleConvert::toF32BE, 4) },
+        { "config.bytesPerMillis", bytesPerMillisCase },
+    };
+
+    bool first = true;
+    for (const case_t &c : cases)
+    {
+        if (!selected(c.name, prefixes))
+            continue;
+
+        const result_t result = measure(c, minTime);
+        const double ns = result.seconds * 1e9 / result.iterations;
+        const double mb = result.bytes / result.seconds / 1e6;
+
+        cout << (first ? "[\n  " : ",\n  ")
+             << "{\"name\": \"" << c.name
+             << "\", \"kernels\": \"" << sampleConvert::kernels()
+             << "\", \"iterations\": " << result.iterations
+             << ", \"bytes\": " << result.bytes
+             << std::setprecision(6) << std::fixed
+             << ", \"seconds\": " << result.seconds
+             << std::setprecision(1)
+             << ", \"nsPerOp\": " << ns
+             << ", \"mbPerSecond\": " << mb
+             << "}" << std::flush;
+        first = false;
+    }
+    if (!first)
+        cout << "\n]" << endl;
+
+    return EXIT_SUCCESS;
+}
@@ -88,6 +88,7 @@ void IniConfig::clear()
     sidplay2_s.database.clear();
     sidplay2_s.playLength   = 0;           // INFINITE
     sidplay2_s.recordLength = (3 * 60 + 30) * 1000; // 3.5 minutes
+    sidplay2_s.crossfadeLength = 0;        // Disabled
     sidplay2_s.kernalRom.clear();
     sidplay2_s.basicRom.clear();
     sidplay2_s.chargenRom.clear();
@@ -106,6 +107,11 @@ void IniConfig::clear()
     audio_s.frequency = SidConfig::DEFAULT_SAMPLING_FREQ;
     audio_s.channels  = 0;
     audio_s.precision = 16;
+    audio_s.ringDepth = 4;
+    audio_s.latency   = 0;
+    audio_s.periods   = 0;
+    audio_s.realtimePolicy   = realtime::OFF;
+    audio_s.realtimePriority = 20;
 
     emulation_s.modelDefault  = SidConfig::PAL;
     emulation_s.modelForced   = false;
@@ -340,6 +346,8 @@ void IniConfig::readSidplay2(iniHandler &ini)
         sidplay2_s.playLength = time;
     if (readTime(ini, TEXT("Default Record Length"), time))
         sidplay2_s.recordLength = time;
+    if (readTime(ini, TEXT("Crossfade Length"), time))
+        sidplay2_s.crossfadeLength = time;
 
     sidplay2_s.kernalRom = readString(ini, TEXT("Kernal Rom"));
     sidplay2_s.basicRom = readString(ini, TEXT("Basic Rom"));
@@ -376,6 +384,27 @@ void IniConfig::readAudio(iniHandler &ini)
     readInt(ini, TEXT("Channels"),  audio_s.channels);
 
     readInt(ini, TEXT("BitsPerSample"), audio_s.precision);
+
+    readInt(ini, TEXT("RingDepth"), audio_s.ringDepth);
+
+    readInt(ini, TEXT("Latency"), audio_s.latency);
+
+    readInt(ini, TEXT("Periods"), audio_s.periods);
+
+    {
+        SID_STRING str = readString(ini, TEXT("Realtime"));
+        if (!str.empty())
+        {
+            if (str.compare(TEXT("FIFO")) == 0)
+                audio_s.realtimePolicy = realtime::FIFO;
+            else if (str.compare(TEXT("RR")) == 0)
+                audio_s.realtimePolicy = realtime::RR;
+            else if (str.compare(TEXT("OFF")) == 0)
+                audio_s.realtimePolicy = realtime::OFF;
+        }
+    }
+
+    readInt(ini, TEXT("RealtimePriority"), audio_s.realtimePriority);
 }
 
 
@@ -27,6 +27,8 @@
 
 #include "sidlib_features.h"
 
+#include "audio/Realtime.h"
+
 #include <sidplayfp/sidplayfp.h>
 #include <sidplayfp/SidConfig.h>
 
@@ -42,6 +44,7 @@ public:
         SID_STRING     database;
         uint_least32_t playLength;
         uint_least32_t recordLength;
+        uint_least32_t crossfadeLength;
         SID_STRING     kernalRom;
         SID_STRING     basicRom;
         SID_STRING     chargenRom;
@@ -66,6 +69,11 @@ public:
         int frequency;
         int channels;
         int precision;
+        int ringDepth;
+        int latency;
+        int periods;
+        realtime::policy_t realtimePolicy;
+        int realtimePriority;
     };
 
     struct emulation_section
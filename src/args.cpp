@@ -21,7 +21,10 @@
 
 #include "player.h"
 
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <thread>
 
 #include <cstring>
 #include <climits>
@@ -57,8 +60,8 @@ bool ConsolePlayer::tryOpenTune(const char *hvscBase)
     std::string newFileName(hvscBase);
 
     newFileName.append(SEPARATOR).append(m_filename);
-    m_tune.load(newFileName.c_str());
-    if (!m_tune.getStatus())
+    m_tune->load(newFileName.c_str());
+    if (!m_tune->getStatus())
     {
         return false;
     }
@@ -75,9 +78,54 @@ bool ConsolePlayer::tryOpenDatabase(const char *hvscBase, const char *suffix)
     std::string newFileName(hvscBase);
 
     newFileName.append(SEPARATOR).append("DOCUMENTS").append(SEPARATOR).append("Songlengths.").append(suffix);
+#ifdef FEAT_NEW_SONLEGTH_DB
+    if (!strcmp(suffix, "md5") && openLengthIndex(newFileName.c_str()))
+        return true;
+#endif
     return m_database.open(newFileName.c_str());
 }
 
+/**
+ * Try the binary index of a Songlengths.md5 DB
+ */
+bool ConsolePlayer::openLengthIndex(const char *database)
+{
+    if (m_lengthIndex.open(database))
+        return true;
+
+    if (m_verboseLevel)
+        cerr << "Songlength index not available: " << m_lengthIndex.error() << endl;
+    return false;
+}
+
+/**
+ * Append the tunes listed in a file to the batch, one per line
+ */
+bool ConsolePlayer::readList(const char *listFile)
+{
+    std::ifstream list(listFile);
+    if (!list.is_open())
+    {
+        displayError(ERR_FILE_OPEN);
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(list, line))
+    {
+        // Drop line endings from foreign systems
+        if (!line.empty() && (line.back() == '\r'))
+            line.pop_back();
+
+        // Skip blank lines and comments
+        if (line.empty() || (line[0] == '#'))
+            continue;
+
+        m_batch.files.push_back(line);
+    }
+    return true;
+}
+
 // Convert time from integer
 bool parseTime(const char *str, uint_least32_t &time)
 {
@@ -131,6 +179,18 @@ bool parseTime(const char *str, uint_least32_t &time)
     return true;
 }
 
+// Convert a positive number, capped at max
+bool parseCount(const char *str, uint_least32_t max, uint_least32_t &value)
+{
+    char *end;
+    const long x = strtol(str, &end, 10);
+    if ((end == str) || (*end != '\0') || (x <= 0))
+        return false;
+
+    value = ((unsigned long)x > max) ? max : (uint_least32_t)x;
+    return true;
+}
+
 bool parseAddress(const char *str, uint_least16_t &address)
 {
     if (*str == '\0')
@@ -379,6 +439,34 @@ int ConsolePlayer::args(int argc, const char *argv[])
             {
                 m_engCfg.powerOnDelay = (uint_least16_t) atoi(&argv[i][8]);
             }
+            else if (strncmp (&argv[i][1], "-crossfade=", 11) == 0)
+            {
+                if (!parseTime (&argv[i][12], m_fade.length))
+                    err = true;
+            }
+            else if (strncmp (&argv[i][1], "-latency=", 9) == 0)
+            {
+                if (!parseCount (&argv[i][10], MAX_LATENCY_MS, m_latency))
+                    err = true;
+            }
+            else if (strncmp (&argv[i][1], "-periods=", 9) == 0)
+            {
+                if (!parseCount (&argv[i][10], MAX_PERIODS, m_periods))
+                    err = true;
+            }
+            else if (strncmp (&argv[i][1], "-realtime", 9) == 0)
+            {
+                if (argv[i][10] == '\0')
+                    m_realtime.policy = realtime::FIFO;
+                else if (strcmp (&argv[i][10], "=fifo") == 0)
+                    m_realtime.policy = realtime::FIFO;
+                else if (strcmp (&argv[i][10], "=rr") == 0)
+                    m_realtime.policy = realtime::RR;
+                else if (strcmp (&argv[i][10], "=off") == 0)
+                    m_realtime.policy = realtime::OFF;
+                else
+                    err = true;
+            }
             else if (strncmp (&argv[i][1], "-fcurve=", 8) == 0)
             {
                 if (strncmp (&argv[i][9], "auto", 4) == 0)
@@ -412,10 +500,126 @@ int ConsolePlayer::args(int argc, const char *argv[])
                 if (argv[i][4] != '\0')
                     m_outfile = &argv[i][4];
             }
+#ifdef HAVE_FLAC
+            else if (strncmp (&argv[i][1], "-flac", 5) == 0)
+            {
+                m_driver.output = OUT_FLAC;
+                m_driver.file   = true;
+                if (argv[i][6] != '\0')
+                    m_outfile = &argv[i][6];
+            }
+#endif
             else if (strncmp (&argv[i][1], "-info", 5) == 0)
             {
                 m_driver.info   = true;
             }
+
+            // Batch rendering
+            else if (argv[i][1] == 'j')
+            {
+                m_batch.enabled = true;
+                if (argv[i][2] != '\0')
+                {
+                    const int jobs = atoi(&argv[i][2]);
+                    if (jobs < 1)
+                        err = true;
+                    m_batch.jobs = jobs;
+                }
+                else
+                    m_batch.jobs = std::thread::hardware_concurrency();
+            }
+            else if (strncmp (&argv[i][1], "-list=", 6) == 0)
+            {
+                m_batch.enabled = true;
+                if (!readList(&argv[i][7]))
+                    return -1;
+            }
+            else if (strncmp (&argv[i][1], "-journal=", 9) == 0)
+            {
+                m_batch.enabled = true;
+                m_batch.journal = &argv[i][10];
+                if (*m_batch.journal == '\0')
+                    err = true;
+            }
+            else if (strncmp (&argv[i][1], "-stems", 6) == 0)
+            {
+                m_batch.enabled = true;
+                if ((argv[i][7] == '\0') || (strcmp (&argv[i][7], "=voices") == 0))
+                    m_batch.stems = STEMS_VOICES;
+                else if (strcmp (&argv[i][7], "=chips") == 0)
+                    m_batch.stems = STEMS_CHIPS;
+                else
+                    err = true;
+            }
+            else if (strncmp (&argv[i][1], "-shard=", 7) == 0)
+            {
+                m_batch.enabled = true;
+                char *sep;
+                const long shard = strtol(&argv[i][8], &sep, 10);
+                if ((*sep != '/') || (shard < 1))
+                    err = true;
+                else
+                {
+                    const long shards = atol(sep + 1);
+                    if (shard > shards)
+                        err = true;
+                    m_batch.shard  = shard;
+                    m_batch.shards = shards;
+                }
+            }
+            // Benchmark
+            else if (strcmp (&argv[i][1], "-bench-matrix") == 0)
+            {
+                m_bench.enabled = true;
+                m_bench.matrix  = true;
+            }
+            else if (strncmp (&argv[i][1], "-bench-repeat=", 14) == 0)
+            {
+                const int repeat = atoi(&argv[i][15]);
+                if (repeat < 1)
+                    err = true;
+                m_bench.repeat = repeat;
+            }
+            else if (strncmp (&argv[i][1], "-bench-baseline=", 16) == 0)
+            {
+                m_bench.baseline = &argv[i][17];
+                if (*m_bench.baseline == '\0')
+                    err = true;
+            }
+            else if (strncmp (&argv[i][1], "-bench-threshold=", 17) == 0)
+            {
+                m_bench.threshold = atof(&argv[i][18]);
+                if (m_bench.threshold < 0.)
+                    err = true;
+            }
+            else if (strncmp (&argv[i][1], "-bench", 6) == 0)
+            {
+                m_bench.enabled = true;
+                if (argv[i][7] == '=')
+                {
+                    const int seconds = atoi(&argv[i][8]);
+                    if (seconds < 1)
+                        err = true;
+                    m_bench.seconds = seconds;
+                }
+                else if (argv[i][7] != '\0')
+                    err = true;
+            }
+            else if (strcmp (&argv[i][1], "-json") == 0)
+            {
+                m_bench.json = true;
+            }
+#ifdef HAVE_DAEMON
+            else if (strncmp (&argv[i][1], "-daemon", 7) == 0)
+            {
+                m_daemon.enabled = true;
+                if (argv[i][8] == '=')
+                    m_daemon.socket = &argv[i][9];
+                else if (argv[i][8] != '\0')
+                    err = true;
+            }
+#endif
+
 #ifdef HAVE_SIDPLAYFP_BUILDERS_RESIDFP_H
             else if (strcmp (&argv[i][1], "-residfp") == 0)
             {
@@ -476,8 +680,7 @@ int ConsolePlayer::args(int argc, const char *argv[])
         {   // Reading file name
             if (infile == 0)
                 infile = i;
-            else
-                err = true;
+            m_batch.files.push_back(argv[i]);
         }
 
         if (err)
@@ -491,29 +694,110 @@ int ConsolePlayer::args(int argc, const char *argv[])
 
     const char* hvscBase = getenv("HVSC_BASE");
 
-    // Load the tune
-    m_filename = argv[infile];
-    m_tune.load(m_filename.c_str());
-    if (!m_tune.getStatus())
-    {
-        std::string errorString(m_tune.statusString());
+    if (m_batch.files.size() > 1)
+        m_batch.enabled = true;
+
+    if (m_bench.enabled)
+    {   // Every given tune is measured in turn
+        if (m_batch.files.empty())
+        {
+            displayError ("ERROR: No files to benchmark");
+            return -1;
+        }
+
+        if (m_driver.file || m_daemon.enabled)
+        {
+            displayError ("ERROR: Cannot benchmark while recording or in daemon mode");
+            return -1;
+        }
+
+        m_batch.enabled = false;
+    }
+    else if (m_daemon.enabled)
+    {   // Tunes come from the control socket
+        if (m_batch.enabled || !m_batch.files.empty())
+        {
+            displayError ("ERROR: No files can be given in daemon mode");
+            return -1;
+        }
+
+        if (m_driver.file)
+        {
+            displayError ("ERROR: Cannot record in daemon mode");
+            return -1;
+        }
+
+        // There is no console to talk to
+        if (m_quietLevel < 2)
+            m_quietLevel = 2;
+    }
+    else if (m_batch.enabled)
+    {   // Tunes are loaded by the workers
+        if (m_batch.files.empty())
+        {
+            displayError ("ERROR: No files to render");
+            return -1;
+        }
+
+        // Stems of a tune are spread over all cores by default
+        if (m_batch.jobs == 0)
+            m_batch.jobs = (m_batch.stems != STEMS_NONE) ? std::max(std::thread::hardware_concurrency(), 1u) : 1;
 
-        // Try prepending HVSC_BASE
-        if (!hvscBase || !tryOpenTune(hvscBase))
+        if ((m_batch.stems != STEMS_NONE) && m_outfile && (strcmp(m_outfile, "-") == 0))
         {
-            displayError(errorString.c_str());
+            displayError ("ERROR: Cannot write stems to standard output");
             return -1;
         }
+
+        // Batches always go to files
+        if (!m_driver.file)
+        {
+            m_driver.output = OUT_WAV;
+            m_driver.file   = true;
+        }
     }
+    else if (isPlaylist(argv[infile]))
+    {   // Tunes are loaded once the songlength DB is open
+        if (!readPlaylist(argv[infile]))
+            return -1;
 
-    // If filename specified we can only convert one song
-    if (m_outfile != nullptr)
-        m_track.single = true;
+        if (m_outfile != nullptr)
+        {
+            displayError ("ERROR: Cannot record a playlist to a single file");
+            return -1;
+        }
+    }
+    else
+    {
+        // Load the tune
+        m_filename = argv[infile];
+        m_tune->load(m_filename.c_str());
+        if (!m_tune->getStatus())
+        {
+            std::string errorString(m_tune->statusString());
+
+            // Try prepending HVSC_BASE
+            if (!hvscBase || !tryOpenTune(hvscBase))
+            {
+                displayError(errorString.c_str());
+                return -1;
+            }
+        }
+
+        // If filename specified we can only convert one song
+        if (m_outfile != nullptr)
+            m_track.single = true;
+    }
 
     // Can only loop if not creating audio files
     if (m_driver.output > OUT_SOUNDCARD)
         m_track.loop = false;
 
+    // Stems must line up and be the same on every run,
+    // or the journal would never match a finished job
+    if ((m_batch.stems != STEMS_NONE) && (m_engCfg.powerOnDelay > SidConfig::MAX_POWER_ON_DELAY))
+        m_engCfg.powerOnDelay = 0;
+
     // Check to see if we are trying to generate an audio file
     // whilst using a hardware emulation
     if (m_driver.file && (m_driver.sid >= EMU_HARDSID))
@@ -522,13 +806,15 @@ int ConsolePlayer::args(int argc, const char *argv[])
         return -1;
     }
 
-    if (m_driver.info && m_driver.file)
+    if (m_driver.info && m_driver.file
+        && (m_driver.output != OUT_WAV) && (m_driver.output != OUT_FLAC))
     {
-        displayError ("WARNING: metadata can be added only to wav files");
+        displayError ("WARNING: metadata can be added only to wav and flac files");
     }
 
     // Select the desired track
-    m_track.first    = m_tune.selectSong (m_track.first);
+    if (!m_batch.enabled && !m_daemon.enabled && !m_playlist.enabled && !m_bench.enabled)
+        m_track.first = m_tune->selectSong (m_track.first);
     m_track.selected = m_track.first;
     if (m_track.single)
         m_track.songs = 1;
@@ -581,21 +867,26 @@ int ConsolePlayer::args(int argc, const char *argv[])
 #else
                     const char *database = (m_iniCfg.sidplay2()).database.c_str();
 #endif
-                    if (!m_database.open(database))
+                    const bool md5 = (m_iniCfg.sidplay2()).database.find(TEXT(".md5")) != SID_STRING::npos;
+                    bool indexed = false;
+#if defined(FEAT_NEW_SONLEGTH_DB) && !defined(_WIN32)
+                    indexed = md5 && openLengthIndex(database);
+#endif
+                    if (!indexed && !m_database.open(database))
                     {
                         displayError (m_database.error ());
                         return -1;
                     }
 
-                    if ((m_iniCfg.sidplay2()).database.find(TEXT(".md5")) != SID_STRING::npos)
-                        songlengthDB = SLDB_MD5;
-                    else
-                        songlengthDB = SLDB_TXT;
+                    songlengthDB = md5 ? SLDB_MD5 : SLDB_TXT;
                 }
             }
         }
     }
 
+    if (m_playlist.enabled && !playlistStart())
+        return -1;
+
 #if HAVE_TSID == 1
     // Set TSIDs base directory
     if (!m_tsid.setBaseDir(true))
@@ -606,9 +897,9 @@ int ConsolePlayer::args(int argc, const char *argv[])
 #endif
 
     // Configure engine with settings
-    if (!m_engine.config (m_engCfg))
+    if (!m_engine->config (m_engCfg))
     {   // Config failed
-        displayError (m_engine.error ());
+        displayError (m_engine->error ());
         return -1;
     }
     return 1;
@@ -622,7 +913,7 @@ void ConsolePlayer::displayArgs (const char *arg)
     if (arg)
         out << "Option Error: " << arg << endl;
     else
-        out << "Syntax: " << m_name << " [-<option>...] <datafile>" << endl;
+        out << "Syntax: " << m_name << " [-<option>...] <datafile>..." << endl;
 
     out << "Options:" << endl
         << " --help|-h    display this screen" << endl
@@ -662,11 +953,41 @@ void ConsolePlayer::displayArgs (const char *arg)
 #endif
         << " -r[i|r][f]   set resampling method (default: resample interpolate)" << endl
         << "              Use 'f' to enable fast resampling (only for reSID)" << endl
+        << " --crossfade=<num> crossfade consecutive tunes in [mins:]secs[.milli] format (default: 0)" << endl
+        << " --latency=<num> sound card buffering in milliseconds (default: driver's choice)" << endl
+        << " --periods=<num> number of periods the latency is split in (default: driver's choice)" << endl
+        << " --realtime[=fifo|rr|off] realtime scheduling and locked memory for playback" << endl
+        << "              (default: fifo when given)" << endl
         << " --fcurve=<num>|auto Controls the filter curve in the ReSIDfp emulation (0.0 to 1.0, default: 0.5)" << endl
 
         << " -w[name]     create wav file (default: <datafile>[n].wav)" << endl
         << " --au[name]   create au file (default: <datafile>[n].au)" << endl
-        << " --info       add metadata to wav file" << endl;
+#ifdef HAVE_FLAC
+        << " --flac[name] create flac file (default: <datafile>[n].flac)" << endl
+#endif
+        << " --info       add metadata to wav and flac files" << endl
+
+        << " -j[num]      render all given files to disk using <num> threads (default: all cores)" << endl
+        << "              Output name is a template: %f file, %n subtune, %t title, %a author," << endl
+        << "              %r released, %p directory" << endl
+        << " --list=<file> add the files listed in <file> to the batch" << endl
+        << " --journal=<file> record finished jobs in <file> and skip them on restart" << endl
+        << " --shard=<k>/<n> only render the k-th of n deterministic parts of the batch" << endl
+        << " --stems[=voices|chips] render one file per voice or per SID chip, in parallel" << endl
+        << "              using <num> threads from -j (default: all cores)" << endl
+
+        << " --bench[=<secs>] measure how fast the given files are emulated (default: 60)" << endl
+        << " --json       report benchmark results as JSON" << endl
+        << " --bench-matrix benchmark all the given files across engines, sampling methods," << endl
+        << "              frequencies, channels and number of SIDs" << endl
+        << " --bench-repeat=<num> measured runs for each matrix cell (default: 5)" << endl
+        << " --bench-baseline=<file> compare the matrix with a previous JSON report" << endl
+        << " --bench-threshold=<num> slowdown in percent flagged as regression (default: 5)" << endl;
+
+#ifdef HAVE_DAEMON
+    out << " --daemon[=<socket>] stay resident and take commands from a Unix socket" << endl
+        << "              (default: $XDG_RUNTIME_DIR/sidplayfp.sock)" << endl;
+#endif
 
 #ifdef HAVE_SIDPLAYFP_BUILDERS_RESIDFP_H
     out << " --residfp    use reSIDfp emulation (default)" << endl;
@@ -690,6 +1011,10 @@ void ConsolePlayer::displayArgs (const char *arg)
             out << " --exsid      enable exSID support" << endl;
     }
 #endif
+    out << endl
+        << "A single M3U or PLS playlist can be given instead of <datafile>," << endl
+        << "append #<num> to an entry to play only that track." << endl;
+
     out << endl
         << "Home Page: " PACKAGE_URL << endl;
 }
@@ -26,6 +26,7 @@
 
 #include "IAudio.h"
 #include "AudioConfig.h"
+#include "AudioStats.h"
 
 #include "sidcxx11.h"
 
@@ -49,6 +50,7 @@ private:
 protected:
     AudioConfig _settings;
     short      *_sampleBuffer;
+    audioStats  _stats;
 
 protected:
     void setError(const char* msg)
@@ -78,6 +80,8 @@ public:
     {
         return _errorString.c_str();
     }
+
+    audioStats *stats() override { return &_stats; }
 };
 
 #endif // AUDIOBASE_H
@@ -23,6 +23,10 @@
 
 #include <stdint.h>
 
+// Upper bounds for the requested buffering
+#define MAX_LATENCY_MS 5000
+#define MAX_PERIODS    64
+
 class AudioConfig
 {
 public:
@@ -30,14 +34,21 @@ public:
     int            precision;
     int            channels;
     uint_least32_t bufSize;       // sample buffer size
+    uint_least32_t latency;       // target in ms, 0 for the backend default
+    uint_least32_t periods;       // latency split in, 0 for the backend default
 
     AudioConfig() :
         frequency(48000),
         precision(16),
         channels(1),
-        bufSize(0) {}
+        bufSize(0),
+        latency(0),
+        periods(0) {}
 
     uint_least32_t bytesPerMillis() const { return (precision/8 * channels * frequency) / 1000; }
+
+    uint_least32_t msToFrames(uint_least32_t ms) const { return (uint_least64_t)frequency * ms / 1000; }
+    uint_least32_t framesToMs(uint_least32_t frames) const { return frequency ? (uint_least64_t)frames * 1000 / frequency : 0; }
 };
 
 #endif  // AUDIOCONFIG_H
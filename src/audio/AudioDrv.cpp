@@ -31,6 +31,7 @@
 #endif
 
 // Unix Sound Drivers
+#include "jack/audiodrv.h"
 #include "pulse/audiodrv.h"
 #include "alsa/audiodrv.h"
 #include "oss/audiodrv.h"
@@ -71,6 +72,14 @@ bool audioDrv::open(AudioConfig &cfg)
         res = audio->open(cfg);
     }
 #endif
+// Only reached when no desktop sound server or ALSA device is available
+#ifdef HAVE_JACK
+    if(!res)
+    {
+        audio.reset(new Audio_JACK());
+        res = audio->open(cfg);
+    }
+#endif
 #ifdef HAVE_OSS
     if(!res)
     {
@@ -37,12 +37,17 @@ public:
 
     bool open(AudioConfig &cfg) override;
     void reset() override { audio->reset(); }
-    bool write(uint_least32_t size) override { return audio->write(size); }
+    bool write(uint_least32_t size) override
+    {
+        audioStats::timer timer(audio->stats(), audioStats::DEVICE);
+        return audio->write(size);
+    }
     void close() override { audio->close(); }
     void pause() override { audio->pause(); }
     short *buffer() const override { return audio->buffer(); }
     void getConfig(AudioConfig &cfg) const override { audio->getConfig(cfg); }
     const char *getErrorString() const override { return audio->getErrorString(); }
+    audioStats *stats() override { return audio ? audio->stats() : nullptr; }
 };
 
 #endif // AUDIODRV_H
@@ -0,0 +1,262 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "AudioRing.h"
+
+#include <cstring>
+#include <future>
+#include <new>
+
+audioRing::audioRing(IAudio *device, unsigned int depth) :
+    m_device(device),
+    m_depth(depth ? depth : 1),
+    m_slots(m_depth + 1),
+    m_head(0),
+    m_tail(0),
+    m_running(false),
+    m_paused(false),
+    m_flush(false),
+    m_flushTo(0),
+    m_failed(false),
+    m_underruns(0),
+    m_minFill(0),
+    m_fillSum(0),
+    m_fillCount(0),
+    m_consumerWaiting(false),
+    m_producerWaiting(false),
+    m_policy(realtime::OFF),
+    m_priority(0) {}
+
+audioRing::~audioRing()
+{
+    close();
+}
+
+bool audioRing::open(AudioConfig &cfg)
+{
+    if (m_running)
+    {
+        m_errorString = "RING ERROR: Audio device already open.";
+        return false;
+    }
+
+    if (!m_device->open(cfg))
+        return false;
+
+    m_cfg = cfg;
+
+    try
+    {
+        // Zeroed so the pages are in place before playing
+        m_blocks.reset(new short[m_slots * m_cfg.bufSize]());
+        m_sizes.reset(new uint_least32_t[m_slots]);
+    }
+    catch (std::bad_alloc const &ba)
+    {
+        m_errorString = "RING ERROR: Unable to allocate memory for sample buffers.";
+        m_device->close();
+        return false;
+    }
+
+    m_head = 0;
+    m_tail = 0;
+    m_paused = false;
+    m_flush = false;
+    m_flushTo = 0;
+    m_failed = false;
+    m_underruns = 0;
+    m_minFill = m_depth;
+    m_fillSum = 0;
+    m_fillCount = 0;
+    m_errorString.clear();
+
+    m_running = true;
+    if (m_policy == realtime::OFF)
+    {
+        m_realtime.clear();
+        m_thread = std::thread(&audioRing::run, this);
+        return true;
+    }
+
+    // Wait to know what the thread was granted
+    std::promise<std::string> promoted;
+    std::future<std::string> status = promoted.get_future();
+    m_thread = std::thread([this, &promoted]()
+        {
+            promoted.set_value(realtime::promote(m_policy, m_priority));
+            run();
+        });
+    m_realtime = status.get();
+    return true;
+}
+
+// Consumer side, feeds the device from its own thread
+void audioRing::run()
+{
+    bool starved = true;
+    bool devicePaused = false;
+
+    while (m_running)
+    {
+        const uint_least32_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (m_flush.exchange(false, std::memory_order_acquire))
+        {
+            m_tail.store(m_flushTo.load(std::memory_order_relaxed), std::memory_order_release);
+            m_device->reset();
+            wake(m_producerWaiting, m_spaceReady);
+            starved = true;
+            continue;
+        }
+
+        if (m_paused)
+        {
+            // Hold the queued blocks until playback resumes
+            if (!devicePaused)
+            {
+                m_device->pause();
+                devicePaused = true;
+            }
+            starved = true;
+            sleepUntil(m_consumerWaiting, m_dataReady, [this] { return !m_paused || m_flush || !m_running; });
+            continue;
+        }
+        devicePaused = false;
+
+        const uint_least32_t fill = m_head.load(std::memory_order_acquire) - tail;
+        if (fill == 0)
+        {
+            // Count each time the device runs dry while playing,
+            // the initial fill is not an underrun
+            if (!starved)
+                m_underruns++;
+            starved = true;
+            sleepUntil(m_consumerWaiting, m_dataReady, [this, tail] {
+                return m_head.load(std::memory_order_acquire) != tail
+                    || m_paused || m_flush || !m_running; });
+            continue;
+        }
+
+        if (!starved)
+        {
+            if (fill < m_minFill)
+                m_minFill = fill;
+            m_fillSum += fill;
+            m_fillCount++;
+        }
+        starved = false;
+
+        const uint_least32_t size = m_sizes[tail % m_slots];
+        memcpy(m_device->buffer(), slot(tail), size * sizeof(short));
+        if (!m_device->write(size))
+        {
+            m_failed = true;
+            m_running = false;
+        }
+
+        m_tail.store(tail + 1, std::memory_order_release);
+        wake(m_producerWaiting, m_spaceReady);
+    }
+}
+
+// Producer side, called from the emulation thread
+bool audioRing::write(uint_least32_t size)
+{
+    if (m_failed || !m_running)
+        return false;
+
+    const uint_least32_t head = m_head.load(std::memory_order_relaxed);
+    m_sizes[head % m_slots] = size;
+    m_head.store(head + 1, std::memory_order_release);
+    m_paused = false;
+    wake(m_consumerWaiting, m_dataReady);
+
+    // Wait for the next block to be released by the consumer
+    if ((head + 1 - m_tail.load(std::memory_order_acquire)) > m_depth)
+    {
+        sleepUntil(m_producerWaiting, m_spaceReady, [this, head] {
+            return (head + 1 - m_tail.load(std::memory_order_acquire)) <= m_depth
+                || !m_running; });
+    }
+    return !m_failed;
+}
+
+void audioRing::reset()
+{
+    if (!m_running)
+        return;
+
+    // The device is owned by the consumer thread, let it drop
+    // the queued blocks and reset the backend. Don't wait for it,
+    // the producer can go on filling the ring in the meantime.
+    m_flushTo.store(m_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_flush.store(true, std::memory_order_release);
+    wake(m_consumerWaiting, m_dataReady);
+}
+
+// The consumer stops draining and pauses the device,
+// the next write resumes playback
+void audioRing::pause()
+{
+    if (!m_running)
+        return;
+
+    m_paused = true;
+    wake(m_consumerWaiting, m_dataReady);
+}
+
+void audioRing::stopThread()
+{
+    m_running = false;
+    wake(m_consumerWaiting, m_dataReady);
+    wake(m_producerWaiting, m_spaceReady);
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void audioRing::close()
+{
+    if (m_thread.joinable())
+    {
+        // Play out what is still queued, unless paused
+        sleepUntil(m_producerWaiting, m_spaceReady, [this] {
+            return !m_running || m_paused
+                || (m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire)); });
+        stopThread();
+        m_device->close();
+    }
+
+    m_blocks.reset();
+    m_sizes.reset();
+}
+
+const char *audioRing::getErrorString() const
+{
+    return m_errorString.empty() ? m_device->getErrorString() : m_errorString.c_str();
+}
+
+void audioRing::getStats(stats_t &stats) const
+{
+    const uint_least32_t count = m_fillCount;
+    stats.depth     = m_depth;
+    stats.minFill   = count ? m_minFill.load() : 0;
+    stats.avgFill   = count ? (double)m_fillSum / count : 0.;
+    stats.underruns = m_underruns;
+}
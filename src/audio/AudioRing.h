@@ -0,0 +1,160 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef AUDIORING_H
+#define AUDIORING_H
+
+#include "IAudio.h"
+#include "AudioConfig.h"
+#include "Realtime.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/*
+ * Decouples the emulation from the audio backend.
+ *
+ * The player renders into the blocks of a single producer/single
+ * consumer ring while a dedicated thread drains them into the
+ * wrapped device, so a slow device write doesn't stall the emulation
+ * and an emulation hiccup is absorbed by the queued blocks.
+ */
+class audioRing : public IAudio
+{
+public:
+    struct stats_t
+    {
+        unsigned int   depth;     // Number of queued blocks
+        unsigned int   minFill;   // Lowest fill level seen by the consumer
+        double         avgFill;   // Average fill level seen by the consumer
+        uint_least32_t underruns; // Times the consumer found the ring empty
+    };
+
+private:
+    std::unique_ptr<IAudio> m_device;
+
+    const unsigned int m_depth;
+    unsigned int       m_slots;
+
+    AudioConfig m_cfg;
+
+    std::unique_ptr<short[]>          m_blocks;
+    std::unique_ptr<uint_least32_t[]> m_sizes;
+
+    // Written by the producer only
+    std::atomic<uint_least32_t> m_head;
+    // Written by the consumer only
+    std::atomic<uint_least32_t> m_tail;
+
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_paused;
+    std::atomic<bool> m_flush;
+    std::atomic<uint_least32_t> m_flushTo; // Blocks before this one are dropped
+    std::atomic<bool> m_failed;
+
+    std::atomic<uint_least32_t> m_underruns;
+    std::atomic<uint_least32_t> m_minFill;
+    std::atomic<uint_least32_t> m_fillSum;
+    std::atomic<uint_least32_t> m_fillCount;
+
+    std::thread m_thread;
+
+    // Only used to sleep when a side has to wait for the other,
+    // the ring itself is lock-free
+    std::mutex              m_lock;
+    std::condition_variable m_dataReady;  // Signalled by the producer
+    std::condition_variable m_spaceReady; // Signalled by the consumer
+    std::atomic<bool>       m_consumerWaiting;
+    std::atomic<bool>       m_producerWaiting;
+
+    std::string m_errorString;
+
+    realtime::policy_t m_policy;
+    int                m_priority;
+    std::string        m_realtime;  // What the consumer thread got
+
+private:
+    short *slot(uint_least32_t index) const
+    {
+        return m_blocks ? m_blocks.get() + (index % m_slots) * m_cfg.bufSize : nullptr;
+    }
+
+    void run();
+    void stopThread();
+
+    /*
+     * The fences pair up so that either the waiter sees the new state
+     * or the waker sees the flag, the lock is only taken in the latter
+     * case and orders the notification after the waiter's check.
+     */
+    template<class Predicate>
+    void sleepUntil(std::atomic<bool> &waiting, std::condition_variable &cond, Predicate ready)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        cond.wait(lock, ready);
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    void wake(std::atomic<bool> &waiting, std::condition_variable &cond)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!waiting.load(std::memory_order_relaxed))
+            return;
+        { std::lock_guard<std::mutex> lock(m_lock); }
+        cond.notify_all();
+    }
+
+public:
+    /**
+     * @param device the backend, ownership is taken
+     * @param depth number of blocks that can be queued
+     */
+    audioRing(IAudio *device, unsigned int depth);
+    ~audioRing() override;
+
+    bool open(AudioConfig &cfg) override;
+    void reset() override;
+    bool write(uint_least32_t size) override;
+    void close() override;
+    void pause() override;
+    short *buffer() const override { return slot(m_head.load(std::memory_order_relaxed)); }
+    void getConfig(AudioConfig &cfg) const override { m_device->getConfig(cfg); }
+    const char *getErrorString() const override;
+    audioStats *stats() override { return m_device->stats(); }
+
+    void getStats(stats_t &stats) const;
+
+    /**
+     * Raise the scheduling of the consumer thread,
+     * takes effect at the next open.
+     */
+    void setRealtime(realtime::policy_t policy, int priority) { m_policy = policy; m_priority = priority; }
+
+    /// What the consumer thread actually got
+    const std::string &realtimeStatus() const { return m_realtime; }
+};
+
+#endif // AUDIORING_H
@@ -0,0 +1,149 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "AudioStats.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+
+const char *stageNames[audioStats::STAGES] =
+{
+    "emulation", "processing", "output", "device"
+};
+
+// Upper bound of the bucket holding the given rank
+uint_least64_t percentile(const uint_least32_t *buckets, unsigned int size, uint_least64_t count, unsigned int pct)
+{
+    const uint_least64_t rank = (count * pct + 99) / 100;
+    uint_least64_t seen = 0;
+    for (unsigned int i = 0; i < size; i++)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+            return (uint_least64_t)1 << i;
+    }
+    return (uint_least64_t)1 << (size - 1);
+}
+
+}
+
+void audioStats::reset()
+{
+    for (histogram_t &stage : m_stages)
+    {
+        for (std::atomic<uint_least32_t> &bucket : stage.buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        stage.total.store(0, std::memory_order_relaxed);
+        stage.max.store(0, std::memory_order_relaxed);
+    }
+    for (std::atomic<uint_least32_t> &counter : m_counters)
+        counter.store(0, std::memory_order_relaxed);
+    m_latency.store(0, std::memory_order_relaxed);
+}
+
+void audioStats::record(stage_t stage, std::chrono::steady_clock::duration elapsed)
+{
+    const uint_least32_t us = (uint_least32_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+    unsigned int bucket = 0;
+    while ((bucket < BUCKETS - 1) && (us >> bucket))
+        bucket++;
+
+    histogram_t &histogram = m_stages[stage];
+    histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    histogram.total.fetch_add(us, std::memory_order_relaxed);
+
+    // Only this thread records the stage, no need for a CAS loop
+    if (us > histogram.max.load(std::memory_order_relaxed))
+        histogram.max.store(us, std::memory_order_relaxed);
+}
+
+void audioStats::add(const audioStats &other)
+{
+    for (unsigned int s = 0; s < STAGES; s++)
+    {
+        histogram_t &to = m_stages[s];
+        const histogram_t &from = other.m_stages[s];
+        for (unsigned int i = 0; i < BUCKETS; i++)
+            to.buckets[i].fetch_add(from.buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        to.total.fetch_add(from.total.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        const uint_least32_t max = from.max.load(std::memory_order_relaxed);
+        if (max > to.max.load(std::memory_order_relaxed))
+            to.max.store(max, std::memory_order_relaxed);
+    }
+    for (unsigned int c = 0; c < COUNTERS; c++)
+        m_counters[c].fetch_add(other.m_counters[c].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    const uint_least32_t latency = other.m_latency.load(std::memory_order_relaxed);
+    if (latency)
+        m_latency.store(latency, std::memory_order_relaxed);
+}
+
+void audioStats::report(std::ostream &stream) const
+{
+    // Don't depend on the state of the stream
+    std::ostringstream out;
+
+    out << "Stage       buffers   avg us   p50 us   p99 us   max us  histogram" << std::endl;
+    for (unsigned int s = 0; s < STAGES; s++)
+    {
+        const histogram_t &histogram = m_stages[s];
+
+        uint_least32_t buckets[BUCKETS];
+        uint_least64_t count = 0;
+        for (unsigned int i = 0; i < BUCKETS; i++)
+        {
+            buckets[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+            count += buckets[i];
+        }
+        if (!count)
+            continue;
+
+        out << std::left << std::setw(10) << stageNames[s] << std::right
+            << std::setw(9) << count
+            << std::setw(9) << histogram.total.load(std::memory_order_relaxed) / count
+            << std::setw(9) << percentile(buckets, BUCKETS, count, 50)
+            << std::setw(9) << percentile(buckets, BUCKETS, count, 99)
+            << std::setw(9) << histogram.max.load(std::memory_order_relaxed)
+            << ' ';
+        for (unsigned int i = 0; i < BUCKETS; i++)
+        {
+            if (buckets[i])
+                out << " <" << ((uint_least64_t)1 << i) << ':' << buckets[i];
+        }
+        out << std::endl;
+    }
+
+    out << "xruns " << m_counters[XRUNS].load(std::memory_order_relaxed)
+        << ", recoveries " << m_counters[RECOVERIES].load(std::memory_order_relaxed)
+        << ", short writes " << m_counters[SHORT_WRITES].load(std::memory_order_relaxed)
+        << ", failed writes " << m_counters[FAILED_WRITES].load(std::memory_order_relaxed)
+        << ", late buffers " << m_counters[LATE_BUFFERS].load(std::memory_order_relaxed)
+        << std::endl;
+
+    const uint_least32_t latency = m_latency.load(std::memory_order_relaxed);
+    if (latency)
+        out << "device latency " << std::fixed << std::setprecision(1) << latency / 1000. << " ms" << std::endl;
+
+    stream << out.str();
+}
@@ -0,0 +1,118 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef AUDIOSTATS_H
+#define AUDIOSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <stdint.h>
+
+/*
+ * Timing and error counters of the audio pipeline.
+ *
+ * The time each buffer spends in a stage goes into a histogram with
+ * power of two buckets in microseconds. Everything is updated with
+ * relaxed atomics so the audio threads never wait on a reader,
+ * which may see a summary a few buffers behind.
+ */
+class audioStats
+{
+public:
+    enum stage_t
+    {
+        EMULATION,      // Rendering the buffer
+        PROCESSING,     // Mixing after rendering
+        OUTPUT,         // Handing the buffer to the output
+        DEVICE,         // Backend write
+        STAGES
+    };
+
+    enum counter_t
+    {
+        XRUNS,          // Reported by the device
+        RECOVERIES,     // Device restarted after an error
+        SHORT_WRITES,   // Device took less than the whole buffer
+        FAILED_WRITES,
+        LATE_BUFFERS,   // Took longer to make than to play
+        COUNTERS
+    };
+
+    // Bucket i holds times below 2^i us, the last one everything else
+    static const unsigned int BUCKETS = 24;
+
+    /**
+     * Time a stage for the lifetime of the object.
+     * Does nothing without a stats object.
+     */
+    class timer
+    {
+    private:
+        audioStats *m_stats;
+        const stage_t m_stage;
+        const std::chrono::steady_clock::time_point m_start;
+
+    public:
+        timer(audioStats *stats, stage_t stage) :
+            m_stats(stats),
+            m_stage(stage),
+            m_start(std::chrono::steady_clock::now()) {}
+        ~timer()
+        {
+            if (m_stats)
+                m_stats->record(m_stage, std::chrono::steady_clock::now() - m_start);
+        }
+    };
+
+private:
+    struct histogram_t
+    {
+        std::atomic<uint_least32_t> buckets[BUCKETS];
+        std::atomic<uint_least64_t> total;   // Microseconds
+        std::atomic<uint_least32_t> max;
+    };
+
+    histogram_t m_stages[STAGES];
+    std::atomic<uint_least32_t> m_counters[COUNTERS];
+    std::atomic<uint_least32_t> m_latency;  // Microseconds
+
+public:
+    audioStats() { reset(); }
+
+    void reset();
+
+    void record(stage_t stage, std::chrono::steady_clock::duration elapsed);
+    void count(counter_t counter) { m_counters[counter].fetch_add(1, std::memory_order_relaxed); }
+
+    /// Latest output latency reported by the device
+    void setLatency(uint_least32_t us) { m_latency.store(us, std::memory_order_relaxed); }
+
+    /// Add the figures of another set, e.g. the device ones
+    void add(const audioStats &other);
+
+    /**
+     * Print a summary, one line per stage and one for the counters.
+     * Percentiles are given as the upper bound of their bucket.
+     */
+    void report(std::ostream &out) const;
+};
+
+#endif // AUDIOSTATS_H
@@ -0,0 +1,155 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "FileWriter.h"
+
+#include "Realtime.h"
+
+#include <cstdint>
+#include <cstring>
+
+// Blocks start on a page boundary
+#define BLOCK_ALIGN 4096
+
+fileWriter::fileWriter(size_t blockSize, unsigned int depth) :
+    m_blockSize(blockSize),
+    m_out(nullptr),
+    m_blocks(depth < 2 ? 2 : depth),
+    m_current(nullptr),
+    m_quit(false),
+    m_failed(false)
+{
+    for (block_t &block : m_blocks)
+    {
+        block.storage.reset(new char[m_blockSize + BLOCK_ALIGN]);
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(block.storage.get());
+        block.data = block.storage.get() + ((BLOCK_ALIGN - (addr % BLOCK_ALIGN)) % BLOCK_ALIGN);
+        block.size = 0;
+    }
+}
+
+void fileWriter::start(std::ostream *out)
+{
+    finish();
+
+    m_out    = out;
+    m_quit   = false;
+    m_failed = false;
+    m_full.clear();
+    m_free.clear();
+    for (block_t &block : m_blocks)
+    {
+        block.size = 0;
+        m_free.push_back(&block);
+    }
+    m_current = m_free.front();
+    m_free.pop_front();
+
+    m_thread = std::thread(&fileWriter::run, this);
+}
+
+void fileWriter::run()
+{
+    // Disk writes may block, keep them off the realtime classes
+    realtime::demote();
+
+    std::unique_lock<std::mutex> lk(m_lock);
+    for (;;)
+    {
+        while (m_full.empty() && !m_quit)
+            m_wake.wait(lk);
+        if (m_full.empty())
+            break;
+
+        block_t *block = m_full.front();
+        m_full.pop_front();
+        lk.unlock();
+
+        if (!m_failed)
+        {
+            m_out->write(block->data, block->size);
+            if (m_out->fail())
+                m_failed = true;
+        }
+        block->size = 0;
+
+        lk.lock();
+        m_free.push_back(block);
+        m_freed.notify_one();
+    }
+}
+
+// Hand the current block to the writer and get an empty one
+bool fileWriter::queue()
+{
+    std::unique_lock<std::mutex> lk(m_lock);
+    m_full.push_back(m_current);
+    m_wake.notify_one();
+
+    while (m_free.empty())
+        m_freed.wait(lk);
+    m_current = m_free.front();
+    m_free.pop_front();
+    return !m_failed;
+}
+
+bool fileWriter::write(const void *data, size_t bytes)
+{
+    if (!running())
+        return false;
+
+    const char *src = static_cast<const char*>(data);
+    while (bytes)
+    {
+        const size_t space = m_blockSize - m_current->size;
+        const size_t chunk = bytes < space ? bytes : space;
+        memcpy(m_current->data + m_current->size, src, chunk);
+        m_current->size += chunk;
+        src   += chunk;
+        bytes -= chunk;
+
+        if ((m_current->size == m_blockSize) && !queue())
+            return false;
+    }
+    return !m_failed;
+}
+
+bool fileWriter::finish()
+{
+    if (!running())
+        return !m_failed;
+
+    {
+        std::unique_lock<std::mutex> lk(m_lock);
+        if (m_current->size)
+        {
+            m_full.push_back(m_current);
+            m_current = nullptr;
+        }
+        m_quit = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+
+    if (!m_failed)
+        m_out->flush();
+    m_out = nullptr;
+    return !m_failed;
+}
@@ -0,0 +1,103 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef FILEWRITER_H
+#define FILEWRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Moves the disk writes of the file outputs off the emulation thread.
+ *
+ * Data is gathered into a few large page aligned blocks, full blocks
+ * are written out by a dedicated thread while the next one is being
+ * filled. When all the blocks are queued the caller waits for the
+ * writer to release one, so the memory used stays bounded.
+ */
+class fileWriter
+{
+private:
+    struct block_t
+    {
+        std::unique_ptr<char[]> storage;
+        char  *data;
+        size_t size;
+    };
+
+private:
+    const size_t m_blockSize;
+
+    std::ostream *m_out;
+
+    std::vector<block_t> m_blocks;
+    block_t *m_current;                // Being filled by the caller
+
+    std::thread             m_thread;
+    std::mutex              m_lock;
+    std::condition_variable m_wake;    // Writer waits for full blocks
+    std::condition_variable m_freed;   // Caller waits for empty blocks
+    std::deque<block_t*>    m_full;
+    std::deque<block_t*>    m_free;
+    bool                    m_quit;
+    std::atomic<bool>       m_failed;
+
+private:
+    void run();
+    bool queue();
+
+public:
+    /**
+     * @param blockSize size of each block in bytes
+     * @param depth number of blocks
+     * @throw std::bad_alloc
+     */
+    fileWriter(size_t blockSize = 1 << 20, unsigned int depth = 4);
+    ~fileWriter() { finish(); }
+
+    /**
+     * Start writing to the given stream.
+     */
+    void start(std::ostream *out);
+
+    /**
+     * Copy data to the current block,
+     * waiting for a free one when needed.
+     */
+    bool write(const void *data, size_t bytes);
+
+    /**
+     * Write out everything and stop the thread,
+     * the stream can then be used directly again.
+     */
+    bool finish();
+
+    bool running() const { return m_thread.joinable(); }
+    bool failed() const { return m_failed; }
+};
+
+#endif // FILEWRITER_H
@@ -25,6 +25,7 @@
 #include <stdint.h>
 
 class AudioConfig;
+class audioStats;
 
 class IAudio
 {
@@ -39,6 +40,7 @@ public:
     virtual short *buffer() const = 0;
     virtual void getConfig(AudioConfig &cfg) const = 0;
     virtual const char *getErrorString() const = 0;
+    virtual audioStats *stats() = 0;
 };
 
 #endif // IAUDIO_H
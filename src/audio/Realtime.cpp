@@ -0,0 +1,182 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "Realtime.h"
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  ifdef HAVE_PTHREAD_SETSCHEDPARAM
+#    include <pthread.h>
+#    include <sched.h>
+#  endif
+#  ifdef HAVE_SETPRIORITY
+#    include <sys/resource.h>
+#  endif
+#  if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MLOCKALL)
+#    include <sys/mman.h>
+#  endif
+#endif
+
+// Niceness asked for when realtime scheduling is denied,
+// about what rtkit hands out
+#define FALLBACK_NICE -11
+
+#if !defined(_WIN32) && defined(HAVE_SETPRIORITY)
+// Niceness before the first promotion, what demote() goes back to
+static std::atomic<int> baseNice(INT_MIN);
+#endif
+
+const char *realtime::policyName(policy_t policy)
+{
+    switch (policy)
+    {
+    case FIFO:
+        return "SCHED_FIFO";
+    case RR:
+        return "SCHED_RR";
+    default:
+        return "off";
+    }
+}
+
+std::string realtime::promote(policy_t policy, int priority)
+{
+    if (policy == OFF)
+        return policyName(policy);
+
+    std::ostringstream out;
+
+#ifdef _WIN32
+    // No classes to choose from, go for the top of the normal ones
+    (void)priority;
+    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+        out << "time critical";
+    else
+        out << "normal priority";
+#else
+    std::string reason;
+
+#  ifdef HAVE_PTHREAD_SETSCHEDPARAM
+    const int sched = (policy == RR) ? SCHED_RR : SCHED_FIFO;
+    const int min = sched_get_priority_min(sched);
+    const int max = sched_get_priority_max(sched);
+
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+
+    // An rtprio limit may allow a lower priority
+    int err = EPERM;
+    for (int prio = priority < min ? min : priority > max ? max : priority;
+         (err == EPERM) && (prio >= min); prio--)
+    {
+        param.sched_priority = prio;
+        err = pthread_setschedparam(pthread_self(), sched, &param);
+    }
+    if (err == 0)
+    {
+        out << policyName(policy) << ' ' << param.sched_priority;
+        return out.str();
+    }
+    reason = strerror(err);
+#  else
+    reason = "not supported";
+#  endif
+
+#  ifdef HAVE_SETPRIORITY
+    // On Linux this only affects the calling thread
+    errno = 0;
+    const int current = getpriority(PRIO_PROCESS, 0);
+    if (errno == 0)
+    {
+        int unset = INT_MIN;
+        baseNice.compare_exchange_strong(unset, current);
+
+        for (int nice = FALLBACK_NICE; nice < current; nice++)
+        {
+            if (setpriority(PRIO_PROCESS, 0, nice) == 0)
+            {
+                out << "nice " << nice << " (" << policyName(policy) << ": " << reason << ')';
+                return out.str();
+            }
+        }
+    }
+#  endif
+
+    out << "unchanged (" << policyName(policy) << ": " << reason << ')';
+#endif
+    return out.str();
+}
+
+void realtime::demote()
+{
+    // Windows threads don't inherit the priority of their creator
+#ifndef _WIN32
+#  ifdef HAVE_PTHREAD_SETSCHEDPARAM
+    int sched;
+    struct sched_param param;
+    if ((pthread_getschedparam(pthread_self(), &sched, &param) == 0) && (sched != SCHED_OTHER))
+    {
+        memset(&param, 0, sizeof(param));
+        pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    }
+#  endif
+
+#  ifdef HAVE_SETPRIORITY
+    // Raising the nice value is always allowed
+    const int nice = baseNice;
+    if (nice != INT_MIN)
+    {
+        errno = 0;
+        const int current = getpriority(PRIO_PROCESS, 0);
+        if ((errno == 0) && (current < nice))
+            setpriority(PRIO_PROCESS, 0, nice);
+    }
+#  endif
+#endif
+}
+
+std::string realtime::lockMemory()
+{
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_MLOCKALL)
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+        return "memory locked";
+
+    const std::string reason(strerror(errno));
+
+    // Without room for the future allocations at least keep what we have
+    if (mlockall(MCL_CURRENT) == 0)
+        return "current memory locked (" + reason + ')';
+
+    return "memory not locked (" + reason + ')';
+#else
+    return "memory not locked (not supported)";
+#endif
+}
@@ -0,0 +1,75 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <string>
+
+/*
+ * Keeps the playback path from being preempted or paged out
+ * on a busy host.
+ *
+ * Everything here is best effort: when a request is not allowed
+ * the closest thing that is gets used and the returned text says
+ * what was actually obtained.
+ */
+class realtime
+{
+public:
+    enum policy_t
+    {
+        OFF,
+        FIFO,       // SCHED_FIFO
+        RR          // SCHED_RR
+    };
+
+public:
+    /**
+     * Raise the scheduling of the calling thread.
+     * If the realtime classes are not allowed, e.g. without
+     * CAP_SYS_NICE or an rtprio limit, the lowest nice value
+     * permitted is used instead.
+     *
+     * @param policy the scheduling class
+     * @param priority clamped to the range of the class,
+     *                 lowered if the limits don't allow it
+     * @return a description, e.g. "SCHED_FIFO 20" or "nice -10"
+     */
+    static std::string promote(policy_t policy, int priority);
+
+    /**
+     * Put the calling thread back to normal scheduling.
+     * Threads inherit the class of their creator, so helpers
+     * spawned from a promoted thread call this first.
+     */
+    static void demote();
+
+    /**
+     * Lock all current and future pages in memory.
+     *
+     * @return a description, e.g. "memory locked"
+     */
+    static std::string lockMemory();
+
+    static const char *policyName(policy_t policy);
+};
+
+#endif // REALTIME_H
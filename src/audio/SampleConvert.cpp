@@ -0,0 +1,327 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "SampleConvert.h"
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "sidcxx11.h"
+
+// Vector kernels assume a little endian host
+#if !defined(WORDS_BIGENDIAN) && defined(__GNUC__)
+#  if defined(__x86_64__) || defined(__i386__)
+#    define HAVE_X86_KERNELS
+#    include <immintrin.h>
+#  elif defined(__aarch64__) && defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)
+#    define HAVE_NEON_KERNELS
+#    include <arm_neon.h>
+#  endif
+#endif
+
+// 1/32768 is exact so this matches a division
+#define NORMALIZE (1.f / 32768.f)
+
+namespace
+{
+
+struct kernels_t
+{
+    void (*swap16)(const short *src, void *dst, size_t count);
+    void (*normalize)(const short *src, void *dst, size_t count);
+    void (*normalizeSwap)(const short *src, void *dst, size_t count);
+    const char *name;
+};
+
+// Generic versions, also used for the tails
+
+void swap16Generic(const short *src, void *dst, size_t count)
+{
+    uint16_t *out = static_cast<uint16_t*>(dst);
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint16_t v = src[i];
+        out[i] = (v >> 8) | (v << 8);
+    }
+}
+
+void normalizeGeneric(const short *src, void *dst, size_t count)
+{
+    float *out = static_cast<float*>(dst);
+    for (size_t i = 0; i < count; i++)
+        out[i] = src[i] * NORMALIZE;
+}
+
+void normalizeSwapGeneric(const short *src, void *dst, size_t count)
+{
+    uint32_t *out = static_cast<uint32_t*>(dst);
+    for (size_t i = 0; i < count; i++)
+    {
+        const float f = src[i] * NORMALIZE;
+        uint32_t v;
+        memcpy(&v, &f, 4);
+        out[i] = (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+    }
+}
+
+const kernels_t generic = { swap16Generic, normalizeGeneric, normalizeSwapGeneric, "generic" };
+
+#ifdef HAVE_X86_KERNELS
+
+__attribute__((target("sse2")))
+void swap16Sse2(const short *src, void *dst, size_t count)
+{
+    char *out = static_cast<char*>(dst);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2),
+            _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+    }
+    swap16Generic(src + i, out + i * 2, count - i);
+}
+
+__attribute__((target("sse2")))
+inline void sse2Floats(const short *src, __m128 &lo, __m128 &hi)
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    // Sign extend by moving each sample to the upper half
+    const __m128i l = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    const __m128i h = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    const __m128 scale = _mm_set1_ps(NORMALIZE);
+    lo = _mm_mul_ps(_mm_cvtepi32_ps(l), scale);
+    hi = _mm_mul_ps(_mm_cvtepi32_ps(h), scale);
+}
+
+__attribute__((target("sse2")))
+inline __m128i sse2Swap32(__m128 f)
+{
+    __m128i v = _mm_castps_si128(f);
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    return _mm_or_si128(_mm_slli_epi32(v, 16), _mm_srli_epi32(v, 16));
+}
+
+__attribute__((target("sse2")))
+void normalizeSse2(const short *src, void *dst, size_t count)
+{
+    float *out = static_cast<float*>(dst);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 lo, hi;
+        sse2Floats(src + i, lo, hi);
+        _mm_storeu_ps(out + i, lo);
+        _mm_storeu_ps(out + i + 4, hi);
+    }
+    normalizeGeneric(src + i, out + i, count - i);
+}
+
+__attribute__((target("sse2")))
+void normalizeSwapSse2(const short *src, void *dst, size_t count)
+{
+    uint32_t *out = static_cast<uint32_t*>(dst);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 lo, hi;
+        sse2Floats(src + i, lo, hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), sse2Swap32(lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), sse2Swap32(hi));
+    }
+    normalizeSwapGeneric(src + i, out + i, count - i);
+}
+
+const kernels_t sse2 = { swap16Sse2, normalizeSse2, normalizeSwapSse2, "sse2" };
+
+__attribute__((target("avx2")))
+void swap16Avx2(const short *src, void *dst, size_t count)
+{
+    const __m256i mask = _mm256_setr_epi8(
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    char *out = static_cast<char*>(dst);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 2), _mm256_shuffle_epi8(v, mask));
+    }
+    swap16Generic(src + i, out + i * 2, count - i);
+}
+
+__attribute__((target("avx2")))
+inline __m256 avx2Floats(const short *src)
+{
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)), _mm256_set1_ps(NORMALIZE));
+}
+
+__attribute__((target("avx2")))
+void normalizeAvx2(const short *src, void *dst, size_t count)
+{
+    float *out = static_cast<float*>(dst);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(out + i, avx2Floats(src + i));
+    normalizeGeneric(src + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void normalizeSwapAvx2(const short *src, void *dst, size_t count)
+{
+    const __m256i mask = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    uint32_t *out = static_cast<uint32_t*>(dst);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i v = _mm256_castps_si256(avx2Floats(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_shuffle_epi8(v, mask));
+    }
+    normalizeSwapGeneric(src + i, out + i, count - i);
+}
+
+const kernels_t avx2 = { swap16Avx2, normalizeAvx2, normalizeSwapAvx2, "avx2" };
+
+#endif // HAVE_X86_KERNELS
+
+#ifdef HAVE_NEON_KERNELS
+
+void swap16Neon(const short *src, void *dst, size_t count)
+{
+    uint8_t *out = static_cast<uint8_t*>(dst);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        vst1q_u8(out + i * 2, vrev16q_u8(v));
+    }
+    swap16Generic(src + i, out + i * 2, count - i);
+}
+
+void normalizeNeon(const short *src, void *dst, size_t count)
+{
+    float *out = static_cast<float*>(dst);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const int16x8_t v = vld1q_s16(src + i);
+        vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), NORMALIZE));
+        vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), NORMALIZE));
+    }
+    normalizeGeneric(src + i, out + i, count - i);
+}
+
+void normalizeSwapNeon(const short *src, void *dst, size_t count)
+{
+    uint8_t *out = static_cast<uint8_t*>(dst);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const int16x8_t v = vld1q_s16(src + i);
+        const float32x4_t lo = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), NORMALIZE);
+        const float32x4_t hi = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), NORMALIZE);
+        vst1q_u8(out + i * 4, vrev32q_u8(vreinterpretq_u8_f32(lo)));
+        vst1q_u8(out + i * 4 + 16, vrev32q_u8(vreinterpretq_u8_f32(hi)));
+    }
+    normalizeSwapGeneric(src + i, out + i * 4, count - i);
+}
+
+const kernels_t neon = { swap16Neon, normalizeNeon, normalizeSwapNeon, "neon" };
+
+#endif // HAVE_NEON_KERNELS
+
+const kernels_t &pick()
+{
+#if defined(HAVE_X86_KERNELS)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return sse2;
+#elif defined(HAVE_NEON_KERNELS)
+    return neon;
+#endif
+    return generic;
+}
+
+const kernels_t &selected()
+{
+    static const kernels_t &k = pick();
+    return k;
+}
+
+}
+
+namespace sampleConvert
+{
+
+const void *toS16LE(const short *src, MAYBE_UNUSED void *scratch, MAYBE_UNUSED size_t count)
+{
+#ifdef WORDS_BIGENDIAN
+    selected().swap16(src, scratch, count);
+    return scratch;
+#else
+    return src;
+#endif
+}
+
+const void *toS16BE(const short *src, MAYBE_UNUSED void *scratch, MAYBE_UNUSED size_t count)
+{
+#ifdef WORDS_BIGENDIAN
+    return src;
+#else
+    selected().swap16(src, scratch, count);
+    return scratch;
+#endif
+}
+
+const void *toF32LE(const short *src, void *scratch, size_t count)
+{
+#ifdef WORDS_BIGENDIAN
+    selected().normalizeSwap(src, scratch, count);
+#else
+    selected().normalize(src, scratch, count);
+#endif
+    return scratch;
+}
+
+const void *toF32BE(const short *src, void *scratch, size_t count)
+{
+#ifdef WORDS_BIGENDIAN
+    selected().normalize(src, scratch, count);
+#else
+    selected().normalizeSwap(src, scratch, count);
+#endif
+    return scratch;
+}
+
+const char *kernels()
+{
+    return selected().name;
+}
+
+}
@@ -0,0 +1,50 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SAMPLECONVERT_H
+#define SAMPLECONVERT_H
+
+#include <cstddef>
+
+/*
+ * Conversion of the rendered samples to the file formats.
+ *
+ * The kernels are picked once at runtime for the best instruction
+ * set available (AVX2, SSE2 or NEON) and write to a buffer owned by
+ * the caller, so converting allocates nothing. Each call returns
+ * the converted data, which is the source itself when the host
+ * already uses the requested layout.
+ * Floats are normalized to [-1, 1).
+ */
+namespace sampleConvert
+{
+    /// Size in bytes of the buffer needed to convert count samples
+    inline size_t scratchSize(size_t count) { return count * 4; }
+
+    const void *toS16LE(const short *src, void *scratch, size_t count);
+    const void *toS16BE(const short *src, void *scratch, size_t count);
+    const void *toF32LE(const short *src, void *scratch, size_t count);
+    const void *toF32BE(const short *src, void *scratch, size_t count);
+
+    /// Name of the selected kernels
+    const char *kernels();
+}
+
+#endif // SAMPLECONVERT_H
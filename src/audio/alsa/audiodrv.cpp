@@ -23,8 +23,17 @@
 
 #ifdef HAVE_ALSA
 
+#include <cerrno>
+#include <cstring>
 #include <new>
 
+// Give up on a device that doesn't move for this long
+#define POLL_TIMEOUT_MS 2000
+
+// Buffering when none is configured
+#define DEFAULT_LATENCY_MS 200
+#define DEFAULT_PERIODS 3
+
 Audio_ALSA::Audio_ALSA() :
     AudioBase("ALSA")
 {
@@ -42,6 +51,13 @@ void Audio_ALSA::outOfOrder()
     // Reset everything.
     clearError();
     _audioHandle = nullptr;
+    _sampleBuffer = nullptr;
+    _bounce = nullptr;
+    _mmap = false;
+    _period = 0;
+    _offset = 0;
+    _mapped = 0;
+    _fds.clear();
 }
 
 void Audio_ALSA::checkResult(int err)
@@ -55,6 +71,7 @@ void Audio_ALSA::checkResult(int err)
 bool Audio_ALSA::open(AudioConfig &cfg)
 {
     snd_pcm_hw_params_t *hw_params = nullptr;
+    snd_pcm_sw_params_t *sw_params = nullptr;
 
     try
     {
@@ -63,7 +80,7 @@ bool Audio_ALSA::open(AudioConfig &cfg)
             throw error("Device already in use");
         }
 
-        checkResult(snd_pcm_open(&_audioHandle, "default", SND_PCM_STREAM_PLAYBACK, 0));
+        checkResult(snd_pcm_open(&_audioHandle, "default", SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK));
 
         // May later be replaced with driver defaults.
         AudioConfig tmpCfg = cfg;
@@ -72,7 +89,13 @@ bool Audio_ALSA::open(AudioConfig &cfg)
 
         checkResult(snd_pcm_hw_params_any(_audioHandle, hw_params));
 
-        checkResult(snd_pcm_hw_params_set_access(_audioHandle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED));
+        _mmap = snd_pcm_hw_params_set_access(_audioHandle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+        if (!_mmap)
+        {
+            checkResult(snd_pcm_hw_params_set_access(_audioHandle, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED));
+            // Plain writes simply block
+            checkResult(snd_pcm_nonblock(_audioHandle, 0));
+        }
 
         checkResult(snd_pcm_hw_params_set_format(_audioHandle, hw_params, SND_PCM_FORMAT_S16_LE));
 
@@ -84,29 +107,63 @@ bool Audio_ALSA::open(AudioConfig &cfg)
             tmpCfg.frequency = rate;
         }
 
-        snd_pcm_uframes_t buffer_size = tmpCfg.frequency / 5;
+        const uint_least32_t latency = cfg.latency ? cfg.latency : DEFAULT_LATENCY_MS;
+        const uint_least32_t periods = cfg.periods ? cfg.periods : DEFAULT_PERIODS;
+
+        snd_pcm_uframes_t buffer_size = tmpCfg.msToFrames(latency);
         checkResult(snd_pcm_hw_params_set_buffer_size_near(_audioHandle, hw_params, &buffer_size));
-        tmpCfg.bufSize = buffer_size;
 
-        snd_pcm_uframes_t period_size = buffer_size / 3;
+        snd_pcm_uframes_t period_size = buffer_size / periods;
         checkResult(snd_pcm_hw_params_set_period_size_near(_audioHandle, hw_params, &period_size, nullptr));
 
         checkResult(snd_pcm_hw_params(_audioHandle, hw_params));
 
+        // The device may have rounded both
+        checkResult(snd_pcm_hw_params_get_buffer_size(hw_params, &buffer_size));
+        checkResult(snd_pcm_hw_params_get_period_size(hw_params, &period_size, nullptr));
+        tmpCfg.latency = tmpCfg.framesToMs(buffer_size);
+        tmpCfg.periods = buffer_size / period_size;
+
         snd_pcm_hw_params_free(hw_params);
         hw_params = nullptr;
 
+        // One period of samples at a time
+        _period = period_size;
+        tmpCfg.bufSize = period_size * tmpCfg.channels;
+
+        if (_mmap)
+        {
+            // Wake up for each free period, start once all but one are queued
+            checkResult(snd_pcm_sw_params_malloc(&sw_params));
+            checkResult(snd_pcm_sw_params_current(_audioHandle, sw_params));
+            checkResult(snd_pcm_sw_params_set_avail_min(_audioHandle, sw_params, period_size));
+            checkResult(snd_pcm_sw_params_set_start_threshold(_audioHandle, sw_params, buffer_size - period_size));
+            checkResult(snd_pcm_sw_params(_audioHandle, sw_params));
+            snd_pcm_sw_params_free(sw_params);
+            sw_params = nullptr;
+
+            const int count = snd_pcm_poll_descriptors_count(_audioHandle);
+            checkResult(count);
+            _fds.resize(count);
+            checkResult(snd_pcm_poll_descriptors(_audioHandle, _fds.data(), count));
+        }
+
         try
         {
-            _sampleBuffer = new short[snd_pcm_frames_to_bytes(_audioHandle, tmpCfg.bufSize)];
+            _bounce = new short[tmpCfg.bufSize]();
         }
         catch (std::bad_alloc const &ba)
         {
             throw error("Unable to allocate memory for sample buffers.");
         }
+        _sampleBuffer = _bounce;
 
         // Setup internal Config
         _settings = tmpCfg;
+
+        if (_mmap && !mapArea())
+            throw error("Unable to map the device buffer.");
+
         // Update the users settings
         getConfig (cfg);
         return true;
@@ -117,6 +174,8 @@ bool Audio_ALSA::open(AudioConfig &cfg)
 
         if (hw_params)
             snd_pcm_hw_params_free(hw_params);
+        if (sw_params)
+            snd_pcm_sw_params_free(sw_params);
         if (_audioHandle != nullptr)
             close();
 
@@ -131,28 +190,179 @@ void Audio_ALSA::close()
     if (_audioHandle != nullptr)
     {
         snd_pcm_close(_audioHandle);
-        delete[] _sampleBuffer;
+        delete[] _bounce;
         outOfOrder ();
     }
 }
 
-bool Audio_ALSA::write(uint_least32_t size)
+bool Audio_ALSA::recover(int err)
 {
-    if (_audioHandle == nullptr)
+    if (err == -EPIPE)
+        _stats.count(audioStats::XRUNS);
+
+    err = snd_pcm_recover(_audioHandle, err, 0);
+    if (err < 0)
     {
-        setError("Device not open.");
+        _stats.count(audioStats::FAILED_WRITES);
+        setError(snd_strerror(err));
         return false;
     }
+    _stats.count(audioStats::RECOVERIES);
+    return true;
+}
 
-    int err = snd_pcm_writei(_audioHandle, _sampleBuffer, size);
-    if (err < 0)
+// Sleep on the device until the given number of frames can be written
+bool Audio_ALSA::waitSpace(snd_pcm_uframes_t frames)
+{
+    for (;;)
     {
-        err = snd_pcm_recover(_audioHandle, err, 0);
-        if (err < 0)
+        const snd_pcm_sframes_t avail = snd_pcm_avail_update(_audioHandle);
+        if (avail < 0)
+        {
+            if (!recover(avail))
+                return false;
+            continue;
+        }
+        if ((snd_pcm_uframes_t)avail >= frames)
+            return true;
+
+        // Full but still below the start threshold
+        if (snd_pcm_state(_audioHandle) == SND_PCM_STATE_PREPARED)
+        {
+            const int err = snd_pcm_start(_audioHandle);
+            if ((err < 0) && !recover(err))
+                return false;
+            continue;
+        }
+
+        const int ready = poll(_fds.data(), _fds.size(), POLL_TIMEOUT_MS);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            setError(strerror(errno));
+            return false;
+        }
+        if (ready == 0)
         {
-            setError(snd_strerror(err));
+            setError("Device timeout.");
             return false;
         }
+
+        // Errors show up at the next avail_update
+        unsigned short revents;
+        snd_pcm_poll_descriptors_revents(_audioHandle, _fds.data(), _fds.size(), &revents);
+    }
+}
+
+/*
+ * Point the sample buffer at the next period of the device ring.
+ * If the free space wraps around the end of the ring the period is
+ * rendered to the bounce buffer and copied on write instead.
+ */
+bool Audio_ALSA::mapArea()
+{
+    if (!waitSpace(_period))
+        return false;
+
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset;
+    snd_pcm_uframes_t frames = _period;
+    const int err = snd_pcm_mmap_begin(_audioHandle, &areas, &offset, &frames);
+    if (err < 0)
+    {
+        if (!recover(err))
+            return false;
+        _mapped = 0;
+        _sampleBuffer = _bounce;
+        return true;
+    }
+
+    if (frames < _period)
+    {
+        _mapped = 0;
+        _sampleBuffer = _bounce;
+        return true;
+    }
+
+    _offset = offset;
+    _mapped = frames;
+    _sampleBuffer = reinterpret_cast<short*>(static_cast<char*>(areas[0].addr)
+        + (areas[0].first + offset * areas[0].step) / 8);
+    return true;
+}
+
+bool Audio_ALSA::writeMapped(uint_least32_t size)
+{
+    snd_pcm_uframes_t frames = size / _settings.channels;
+
+    if (_mapped)
+    {
+        // Rendered in place, hand it over
+        const snd_pcm_sframes_t done = snd_pcm_mmap_commit(_audioHandle, _offset, frames);
+        if ((done < 0) && !recover(done))
+            return false;
+        if ((done >= 0) && ((snd_pcm_uframes_t)done < frames))
+            _stats.count(audioStats::SHORT_WRITES);
+    }
+    else
+    {
+        // Copy the bounce buffer, in pieces if the ring wraps
+        const char *data = reinterpret_cast<const char*>(_bounce);
+        while (frames)
+        {
+            if (!waitSpace(1))
+                return false;
+
+            const snd_pcm_channel_area_t *areas;
+            snd_pcm_uframes_t offset;
+            snd_pcm_uframes_t chunk = frames;
+            int err = snd_pcm_mmap_begin(_audioHandle, &areas, &offset, &chunk);
+            if (err < 0)
+            {
+                if (!recover(err))
+                    return false;
+                continue;
+            }
+
+            const size_t bytes = snd_pcm_frames_to_bytes(_audioHandle, chunk);
+            memcpy(static_cast<char*>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8, data, bytes);
+
+            const snd_pcm_sframes_t done = snd_pcm_mmap_commit(_audioHandle, offset, chunk);
+            if (done < 0)
+            {
+                if (!recover(done))
+                    return false;
+                continue;
+            }
+            data   += bytes;
+            frames -= chunk;
+        }
+    }
+
+    return mapArea();
+}
+
+bool Audio_ALSA::write(uint_least32_t size)
+{
+    if (_audioHandle == nullptr)
+    {
+        setError("Device not open.");
+        return false;
+    }
+
+    if (_mmap)
+        return writeMapped(size);
+
+    const snd_pcm_uframes_t frames = size / _settings.channels;
+    const snd_pcm_sframes_t done = snd_pcm_writei(_audioHandle, _sampleBuffer, frames);
+    if (done < 0)
+        return recover(done);
+
+    if ((snd_pcm_uframes_t)done < frames)
+    {
+        // Interrupted by a signal, the rest is dropped
+        _stats.count(audioStats::SHORT_WRITES);
     }
     return true;
 }
@@ -35,18 +35,39 @@
 
 
 #include <alsa/asoundlib.h>
-#include "../AudioBase.h"
+#include <poll.h>
+
+#include <vector>
 
+#include "../AudioBase.h"
 
+/*
+ * Where supported the device is opened in mmap mode and the engine
+ * renders each period straight into the ALSA ring, the device is
+ * non-blocking and waited on with poll(). Otherwise the samples are
+ * written with snd_pcm_writei from our own buffer.
+ */
 class Audio_ALSA: public AudioBase
 {
 private:  // ------------------------------------------------------- private
     snd_pcm_t *_audioHandle;
 
+    bool               _mmap;
+    snd_pcm_uframes_t  _period;   // Frames rendered at a time
+    snd_pcm_uframes_t  _offset;   // Of the mapped area being rendered
+    snd_pcm_uframes_t  _mapped;   // Frames mapped, 0 if rendering to the bounce buffer
+    short             *_bounce;   // For when the area wraps
+    std::vector<struct pollfd> _fds;
+
 private:
     void outOfOrder();
     static void checkResult(int err);
 
+    bool recover(int err);
+    bool waitSpace(snd_pcm_uframes_t frames);
+    bool mapArea();
+    bool writeMapped(uint_least32_t size);
+
 public:  // --------------------------------------------------------- public
     Audio_ALSA();
     ~Audio_ALSA() override;
@@ -22,8 +22,8 @@
  */
 
 #include "auFile.h"
+#include "../SampleConvert.h"
 
-#include <vector>
 #include <iomanip>
 #include <fstream>
 #include <new>
@@ -186,7 +186,8 @@ auFile::auFile(const std::string &name) :
     auHdr(defaultAuHdr),
     file(nullptr),
     headerWritten(false),
-    precision(32)
+    precision(32),
+    scratch(nullptr)
 {}
 
 bool auFile::open(AudioConfig &cfg)
@@ -204,18 +205,23 @@ bool auFile::open(AudioConfig &cfg)
     if (name.empty())
         return false;
 
-    if (file && !file->fail())
+    if (file)
         close();
 
+    clearError();
+
     byteCount = 0;
 
     // We need to make a buffer for the user
     try
     {
         _sampleBuffer = new short[bufSize];
+        scratch = new char[sampleConvert::scratchSize(bufSize)];
     }
     catch (std::bad_alloc const &ba)
     {
+        delete[] _sampleBuffer;
+        _sampleBuffer = nullptr;
         setError("Unable to allocate memory for sample buffers.");
         return false;
     }
@@ -232,65 +238,83 @@ bool auFile::open(AudioConfig &cfg)
     else
     {
         file = new std::ofstream(name.c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+        if (file->fail())
+        {
+            setError("Unable to open output file.");
+            delete file;
+            file = nullptr;
+            delete[] _sampleBuffer;
+            _sampleBuffer = nullptr;
+            delete[] scratch;
+            scratch = nullptr;
+            return false;
+        }
     }
 
+    writer.start(file);
+
     _settings = cfg;
     return true;
 }
 
 bool auFile::write(uint_least32_t size)
 {
-    if (file && !file->fail())
+    if (file && !writer.failed())
     {
         unsigned long int bytes = size;
         if (!headerWritten)
         {
-            file->write((char*)&auHdr, sizeof(auHeader));
+            writer.write(&auHdr, sizeof(auHeader));
             headerWritten = true;
         }
 
+        const void *data;
         if (precision == 16)
         {
-            std::vector<uint_least16_t> buffer(size);
             bytes *= 2;
-            for (unsigned long i=0; i<size; i++)
-            {
-                uint_least16_t temp = _sampleBuffer[i];
-                buffer[i] = endian_big16((uint8_t*)&temp);
-            }
-            file->write((char*)&buffer.front(), bytes);
+            data = sampleConvert::toS16BE(_sampleBuffer, scratch, size);
         }
         else
         {
-            std::vector<float> buffer(size);
             bytes *= 4;
-            // normalize floats
-            for (unsigned long i=0; i<size; i++)
-            {
-                float temp = ((float)_sampleBuffer[i])/32768.f;
-                buffer[i] = endian_big32((uint8_t*)&temp);
-            }
-            file->write((char*)&buffer.front(), bytes);
+            data = sampleConvert::toF32BE(_sampleBuffer, scratch, size);
         }
+        writer.write(data, bytes);
         byteCount += bytes;
 
+        return !writer.failed();
     }
-    return true;
+    return false;
 }
 
 void auFile::close()
 {
-    if (file && !file->fail())
+    if (file == nullptr)
+        return;
+
+    // Let the queued data reach the file
+    if (!writer.finish())
+        setError("Unable to write output file.");
+
+    if (file != &std::cout)
     {
-        // update length field in header
-        endian_big32(auHdr.dataSize, byteCount);
-        if (file != &std::cout)
+        if (!file->fail())
         {
+            // update length field in header
+            endian_big32(auHdr.dataSize, byteCount);
             file->seekp(0, std::ios::beg);
             file->write((char*)&auHdr, sizeof(auHeader));
-            delete file;
         }
-        file = nullptr;
-        delete[] _sampleBuffer;
+
+        // The final flush can still fail, on a full disk for example
+        static_cast<std::ofstream*>(file)->close();
+        if (file->fail())
+            setError("Unable to write output file.");
+        delete file;
     }
+    file = nullptr;
+    delete[] _sampleBuffer;
+    _sampleBuffer = nullptr;
+    delete[] scratch;
+    scratch = nullptr;
 }
@@ -28,6 +28,7 @@
 #include <string>
 
 #include "../AudioBase.h"
+#include "../FileWriter.h"
 
 struct auHeader                         // little endian format
 {
@@ -59,6 +60,10 @@ private:
     bool headerWritten;
     int precision;
 
+    char *scratch; // Converted samples
+
+    fileWriter writer;
+
 public:
     auFile(const std::string &name);
     ~auFile() override { close(); }
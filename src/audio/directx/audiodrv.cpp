@@ -131,8 +131,13 @@ bool Audio_DirectX::open (AudioConfig &cfg, HWND hwnd)
         }
         lpDsbPrimary->Release ();
 
-        // Buffer size reduced to 2 blocks of 500ms
-        bufSize = wfm.nSamplesPerSec / 2 * wfm.nBlockAlign;
+        // Buffer size reduced to 2 blocks of 500ms,
+        // the latency target is split among them if given
+        bufSize = cfg.latency
+            ? cfg.msToFrames(cfg.latency) / AUDIO_DIRECTX_BUFFERS * wfm.nBlockAlign
+            : wfm.nSamplesPerSec / 2 * wfm.nBlockAlign;
+        if (bufSize < wfm.nBlockAlign)
+            bufSize = wfm.nBlockAlign;
 
         // Allocate secondary buffers
         memset (&dsbdesc, 0, sizeof(DSBUFFERDESC));
@@ -183,6 +188,8 @@ bool Audio_DirectX::open (AudioConfig &cfg, HWND hwnd)
 
         // Update the users settings
         cfg.bufSize   = bufSize / 2;
+        cfg.latency   = cfg.framesToMs(bufSize / wfm.nBlockAlign * AUDIO_DIRECTX_BUFFERS);
+        cfg.periods   = AUDIO_DIRECTX_BUFFERS;
         _settings     = cfg;
         isPlaying     = false;
         _sampleBuffer = (short*)lpvData;
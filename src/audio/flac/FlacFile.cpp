@@ -0,0 +1,286 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "FlacFile.h"
+
+#ifdef HAVE_FLAC
+
+#include <fstream>
+#include <new>
+
+#include <cstdlib>
+
+#define BITS_PER_SAMPLE 16
+
+// libFLAC default
+#define COMPRESSION_LEVEL 5
+
+namespace
+{
+
+// Vorbis comments must be utf-8
+std::string latin1ToUtf8(const char *str)
+{
+    std::string utf8;
+    for (; *str; str++)
+    {
+        const uint8_t c = *str;
+        if (c < 0x80)
+        {
+            utf8.push_back(c);
+        }
+        else
+        {
+            utf8.push_back(0xc0 | (c >> 6));
+            utf8.push_back(0x80 | (c & 0x3f));
+        }
+    }
+    return utf8;
+}
+
+void addComment(FLAC__StreamMetadata *tags, const char *field, const char *value)
+{
+    FLAC__StreamMetadata_VorbisComment_Entry entry;
+    if (!FLAC__metadata_object_vorbiscomment_entry_from_name_value_pair(&entry, field, latin1ToUtf8(value).c_str()))
+        return;
+
+    // The entry is taken over by the block
+    if (!FLAC__metadata_object_vorbiscomment_append_comment(tags, entry, false))
+        free(entry.entry);
+}
+
+}
+
+FlacFile::FlacFile(const std::string &name, unsigned int threads) :
+    AudioBase("FLACFILE"),
+    name(name),
+    file(nullptr),
+    position(0),
+    encoder(nullptr),
+    tags(nullptr),
+    threads(threads)
+{}
+
+FlacFile::~FlacFile()
+{
+    close();
+
+    if (tags)
+        FLAC__metadata_object_delete(tags);
+}
+
+FLAC__StreamEncoderWriteStatus FlacFile::writeCallback(const FLAC__StreamEncoder *,
+    const FLAC__byte buffer[], size_t bytes, uint32_t, uint32_t, void *clientData)
+{
+    FlacFile *self = static_cast<FlacFile*>(clientData);
+
+    // The writer is stopped once libFLAC seeks back to the headers
+    const bool ok = self->writer.running()
+        ? self->writer.write(buffer, bytes)
+        : self->file->write(reinterpret_cast<const char*>(buffer), bytes).good();
+    if (!ok)
+        return FLAC__STREAM_ENCODER_WRITE_STATUS_FATAL_ERROR;
+
+    self->position += bytes;
+    return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+}
+
+FLAC__StreamEncoderSeekStatus FlacFile::seekCallback(const FLAC__StreamEncoder *,
+    FLAC__uint64 absoluteByteOffset, void *clientData)
+{
+    FlacFile *self = static_cast<FlacFile*>(clientData);
+
+    // Only used when finishing, to update STREAMINFO,
+    // so the queued data must reach the file first
+    if (!self->writer.finish())
+        return FLAC__STREAM_ENCODER_SEEK_STATUS_ERROR;
+
+    if (!self->file->seekp(absoluteByteOffset))
+        return FLAC__STREAM_ENCODER_SEEK_STATUS_ERROR;
+
+    self->position = absoluteByteOffset;
+    return FLAC__STREAM_ENCODER_SEEK_STATUS_OK;
+}
+
+FLAC__StreamEncoderTellStatus FlacFile::tellCallback(const FLAC__StreamEncoder *,
+    FLAC__uint64 *absoluteByteOffset, void *clientData)
+{
+    // The stream itself lags behind while the writer is running
+    *absoluteByteOffset = static_cast<FlacFile*>(clientData)->position;
+    return FLAC__STREAM_ENCODER_TELL_STATUS_OK;
+}
+
+bool FlacFile::open(AudioConfig &cfg)
+{
+    // Lossless integer samples only
+    cfg.precision = BITS_PER_SAMPLE;
+    cfg.bufSize   = cfg.frequency * cfg.channels;
+
+    if (name.empty())
+        return false;
+
+    if ((cfg.channels < 1) || (cfg.channels > 8))
+    {
+        setError("Unsupported number of channels.");
+        return false;
+    }
+
+    if (file)
+        close();
+
+    clearError();
+    position = 0;
+
+    // We need to make a buffer for the user
+    try
+    {
+        _sampleBuffer = new short[cfg.bufSize];
+        samples.resize(cfg.bufSize);
+    }
+    catch (std::bad_alloc const &ba)
+    {
+        setError("Unable to allocate memory for sample buffers.");
+        delete[] _sampleBuffer;
+        _sampleBuffer = nullptr;
+        return false;
+    }
+
+    const bool toStdout = name.compare("-") == 0;
+    if (toStdout)
+    {
+        file = &std::cout;
+    }
+    else
+    {
+        file = new std::ofstream(name.c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+        if (file->fail())
+        {
+            setError("Unable to open output file.");
+            delete file;
+            file = nullptr;
+            delete[] _sampleBuffer;
+            _sampleBuffer = nullptr;
+            return false;
+        }
+    }
+
+    encoder = FLAC__stream_encoder_new();
+    if (!encoder)
+    {
+        close();
+        setError("Unable to allocate memory for the encoder.");
+        return false;
+    }
+
+    FLAC__stream_encoder_set_channels(encoder, cfg.channels);
+    FLAC__stream_encoder_set_bits_per_sample(encoder, BITS_PER_SAMPLE);
+    FLAC__stream_encoder_set_sample_rate(encoder, cfg.frequency);
+    FLAC__stream_encoder_set_compression_level(encoder, COMPRESSION_LEVEL);
+#ifdef HAVE_FLAC__STREAM_ENCODER_SET_NUM_THREADS
+    // Falls back to a single thread if not built with threading
+    if (threads > 1)
+        FLAC__stream_encoder_set_num_threads(encoder, threads);
+#endif
+    if (tags)
+        FLAC__stream_encoder_set_metadata(encoder, &tags, 1);
+
+    writer.start(file);
+
+    // A pipe can't be rewound, the decoder has to do
+    // without the final STREAMINFO there
+    const FLAC__StreamEncoderInitStatus status = FLAC__stream_encoder_init_stream(encoder,
+        &FlacFile::writeCallback,
+        toStdout ? nullptr : &FlacFile::seekCallback,
+        toStdout ? nullptr : &FlacFile::tellCallback,
+        nullptr,
+        this);
+    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+    {
+        close();
+        setError(FLAC__StreamEncoderInitStatusString[status]);
+        return false;
+    }
+
+    _settings = cfg;
+    return !writer.failed();
+}
+
+bool FlacFile::write(uint_least32_t size)
+{
+    if (!encoder || writer.failed())
+        return false;
+
+    for (uint_least32_t i = 0; i < size; i++)
+        samples[i] = _sampleBuffer[i];
+
+    if (!FLAC__stream_encoder_process_interleaved(encoder, samples.data(), size / _settings.channels))
+    {
+        setError("Unable to write output file.");
+        return false;
+    }
+    return true;
+}
+
+void FlacFile::close()
+{
+    if (encoder)
+    {
+        // Encodes the last block and rewrites STREAMINFO
+        if (!FLAC__stream_encoder_finish(encoder))
+            setError("Unable to write output file.");
+        FLAC__stream_encoder_delete(encoder);
+        encoder = nullptr;
+    }
+
+    // Let the queued data reach the file
+    if (!writer.finish())
+        setError("Unable to write output file.");
+
+    if (file && (file != &std::cout))
+    {
+        // The final flush can still fail, on a full disk for example
+        static_cast<std::ofstream*>(file)->close();
+        if (file->fail())
+            setError("Unable to write output file.");
+        delete file;
+    }
+    file = nullptr;
+
+    delete[] _sampleBuffer;
+    _sampleBuffer = nullptr;
+    samples.clear();
+}
+
+void FlacFile::setInfo(const char* title, const char* author, const char* released)
+{
+    if (tags)
+        FLAC__metadata_object_delete(tags);
+
+    // Without memory the file is just left untagged
+    tags = FLAC__metadata_object_new(FLAC__METADATA_TYPE_VORBIS_COMMENT);
+    if (!tags)
+        return;
+
+    addComment(tags, "TITLE", title);
+    addComment(tags, "ARTIST", author);
+    addComment(tags, "COPYRIGHT", released);
+}
+
+#endif // HAVE_FLAC
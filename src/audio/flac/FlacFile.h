@@ -0,0 +1,100 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef FLAC_FILE_H
+#define FLAC_FILE_H
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef HAVE_FLAC
+
+#include <FLAC/metadata.h>
+#include <FLAC/stream_encoder.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../AudioBase.h"
+#include "../FileWriter.h"
+
+/*
+ * A FLAC output file type
+ *
+ * Frames are encoded by libFLAC, which also fills in the
+ * STREAMINFO block, MD5 signature included, when finished.
+ * Samples are always stored as 16 bit.
+ */
+class FlacFile: public AudioBase
+{
+private:
+    std::string name;
+
+    std::ostream *file;
+
+    fileWriter writer;
+
+    // Current offset in the file, for the tell callback
+    uint_least64_t position;
+
+    FLAC__StreamEncoder  *encoder;
+    FLAC__StreamMetadata *tags;       // Vorbis comments
+
+    std::vector<FLAC__int32> samples; // Widened for the encoder
+
+    unsigned int threads;
+
+private:
+    static FLAC__StreamEncoderWriteStatus writeCallback(const FLAC__StreamEncoder *encoder,
+        const FLAC__byte buffer[], size_t bytes, uint32_t frameSamples,
+        uint32_t currentFrame, void *clientData);
+    static FLAC__StreamEncoderSeekStatus seekCallback(const FLAC__StreamEncoder *encoder,
+        FLAC__uint64 absoluteByteOffset, void *clientData);
+    static FLAC__StreamEncoderTellStatus tellCallback(const FLAC__StreamEncoder *encoder,
+        FLAC__uint64 *absoluteByteOffset, void *clientData);
+
+public:
+    /**
+     * @param threads number of encoder threads,
+     *        used only if libFLAC supports them
+     */
+    FlacFile(const std::string &name, unsigned int threads);
+    ~FlacFile() override;
+
+    static const char *extension () { return ".flac"; }
+
+    bool open(AudioConfig &cfg) override;
+
+    // After write call old buffer is invalid and you should
+    // use the new buffer provided instead.
+    bool write(uint_least32_t size) override;
+    void close() override;
+    void pause() override {}
+    void reset() override {}
+
+    void setInfo(const char* title, const char* author, const char* released);
+};
+
+#endif // HAVE_FLAC
+
+#endif /* FLAC_FILE_H */
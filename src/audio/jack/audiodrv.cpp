@@ -0,0 +1,344 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "audiodrv.h"
+
+#ifdef HAVE_JACK
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+
+// Ring length when no latency is configured
+#define DEFAULT_LATENCY_MS 50
+
+// Periods the ring holds at the very least by default
+#define MIN_PERIODS 4
+
+// Longest ring, about 20 seconds at 48 kHz
+#define MAX_RING_FRAMES (1 << 20)
+
+// libjack prints to stderr when no server is running,
+// which is expected while probing for a driver
+static void jackSilent(const char*) {}
+
+// What libjack does by default
+static void jackPrint(const char *msg)
+{
+    fprintf(stderr, "%s\n", msg);
+}
+
+Audio_JACK::Audio_JACK() :
+    AudioBase("JACK"),
+    _client(nullptr)
+{
+    outOfOrder();
+}
+
+Audio_JACK::~Audio_JACK()
+{
+    close ();
+}
+
+void Audio_JACK::outOfOrder()
+{
+    // Reset everything.
+    clearError();
+    _client = nullptr;
+    for (jack_port_t *&port : _ports)
+        port = nullptr;
+    _sampleBuffer = nullptr;
+    _buffer.reset();
+    _ring.reset();
+    _ringFrames = 0;
+    _fillFrames = 0;
+    _sleepMs = 1;
+    _head = 0;
+    _tail = 0;
+    _flush = false;
+    _flushTo = 0;
+    _started = false;
+    _shutdown = false;
+}
+
+/*
+ * Realtime thread, only copies out of the ring.
+ * Must not allocate, lock or make blocking calls.
+ */
+int Audio_JACK::process(jack_nframes_t nframes, void *arg)
+{
+    Audio_JACK *self = static_cast<Audio_JACK*>(arg);
+    const int channels = self->_settings.channels;
+
+    float *out[MAX_CHANNELS];
+    for (int c = 0; c < channels; c++)
+        out[c] = static_cast<float*>(jack_port_get_buffer(self->_ports[c], nframes));
+
+    if (self->_flush.exchange(false, std::memory_order_acquire))
+        self->_tail.store(self->_flushTo.load(std::memory_order_relaxed), std::memory_order_release);
+
+    jack_nframes_t frames = 0;
+    if (self->_started.load(std::memory_order_relaxed))
+    {
+        const uint_least32_t tail = self->_tail.load(std::memory_order_relaxed);
+        const uint_least32_t fill = self->_head.load(std::memory_order_acquire) - tail;
+        frames = fill < nframes ? fill : nframes;
+
+        const uint_least32_t mask = self->_ringFrames - 1;
+        const short *ring = self->_ring.get();
+        for (jack_nframes_t f = 0; f < frames; f++)
+        {
+            const short *frame = ring + ((tail + f) & mask) * channels;
+            for (int c = 0; c < channels; c++)
+                out[c][f] = frame[c] * (1.f / 32768.f);
+        }
+
+        self->_tail.store(tail + frames, std::memory_order_release);
+
+        // The emulation didn't keep up
+        if (frames < nframes)
+            self->_stats.count(audioStats::XRUNS);
+    }
+
+    for (int c = 0; c < channels; c++)
+        memset(out[c] + frames, 0, (nframes - frames) * sizeof(float));
+
+    return 0;
+}
+
+int Audio_JACK::xrun(void *arg)
+{
+    Audio_JACK *self = static_cast<Audio_JACK*>(arg);
+    self->_stats.count(audioStats::XRUNS);
+    return 0;
+}
+
+void Audio_JACK::shutdown(void *arg)
+{
+    Audio_JACK *self = static_cast<Audio_JACK*>(arg);
+    self->_shutdown = true;
+}
+
+// Wire the outputs to the first playback ports, mono goes to both
+void Audio_JACK::connectPorts()
+{
+    const char **playback = jack_get_ports(_client, nullptr, JACK_DEFAULT_AUDIO_TYPE,
+                                           JackPortIsPhysical | JackPortIsInput);
+    if (playback == nullptr)
+        return;
+
+    for (int i = 0; (i < MAX_CHANNELS) && (playback[i] != nullptr); i++)
+    {
+        jack_port_t *port = _ports[i < _settings.channels ? i : 0];
+        jack_connect(_client, jack_port_name(port), playback[i]);
+    }
+
+    jack_free(playback);
+}
+
+bool Audio_JACK::open(AudioConfig &cfg)
+{
+    try
+    {
+        if (_client != nullptr)
+        {
+            throw error("Device already in use");
+        }
+
+        if ((cfg.channels < 1) || (cfg.channels > MAX_CHANNELS))
+        {
+            throw error("Unsupported number of channels.");
+        }
+
+        // Don't start a server, fall back to the next driver instead
+        jack_status_t status;
+        jack_set_error_function(jackSilent);
+        jack_set_info_function(jackSilent);
+        _client = jack_client_open("sidplayfp", JackNoStartServer, &status);
+        jack_set_error_function(jackPrint);
+        jack_set_info_function(jackPrint);
+        if (_client == nullptr)
+        {
+            throw error("Unable to connect to the JACK server.");
+        }
+
+        AudioConfig tmpCfg = cfg;
+
+        // The engine renders at the server rate
+        tmpCfg.frequency = jack_get_sample_rate(_client);
+
+        const jack_nframes_t period = jack_get_buffer_size(_client);
+        tmpCfg.bufSize = period * tmpCfg.channels;
+
+        for (int c = 0; c < tmpCfg.channels; c++)
+        {
+            char name[8];
+            snprintf(name, sizeof(name), "out_%d", c + 1);
+            _ports[c] = jack_port_register(_client, name, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+            if (_ports[c] == nullptr)
+            {
+                throw error("Unable to register the output ports.");
+            }
+        }
+
+        // Enough for the latency target and a few periods,
+        // the period itself is set by the server
+        const uint_least32_t latency = cfg.latency ? cfg.latency : DEFAULT_LATENCY_MS;
+        const uint_least32_t periods = cfg.periods ? cfg.periods : MIN_PERIODS;
+        uint_least64_t fill = tmpCfg.msToFrames(latency);
+        if (fill < (uint_least64_t)period * periods)
+            fill = (uint_least64_t)period * periods;
+        // Keep the power of two below from overflowing
+        if (fill > MAX_RING_FRAMES)
+            fill = (period > MAX_RING_FRAMES) ? period : MAX_RING_FRAMES;
+        _fillFrames = fill;
+        tmpCfg.latency = tmpCfg.framesToMs(_fillFrames);
+        tmpCfg.periods = _fillFrames / period;
+        _ringFrames = 1;
+        while (_ringFrames < _fillFrames)
+            _ringFrames <<= 1;
+
+        try
+        {
+            // Touch everything now, not from the process callback
+            _buffer.reset(new short[tmpCfg.bufSize]());
+            _ring.reset(new short[_ringFrames * tmpCfg.channels]());
+        }
+        catch (std::bad_alloc const &ba)
+        {
+            throw error("Unable to allocate memory for sample buffers.");
+        }
+        _sampleBuffer = _buffer.get();
+
+        // Poll a few times per period when the ring is full
+        _sleepMs = period * 1000 / tmpCfg.frequency / 4;
+        if (_sleepMs < 1)
+            _sleepMs = 1;
+
+        // Setup internal Config
+        _settings = tmpCfg;
+
+        jack_set_process_callback(_client, process, this);
+        jack_set_xrun_callback(_client, xrun, this);
+        jack_on_shutdown(_client, shutdown, this);
+
+        if (jack_activate(_client) != 0)
+        {
+            throw error("Unable to activate the client.");
+        }
+
+        connectPorts();
+
+        // Update the users settings
+        getConfig (cfg);
+        return true;
+    }
+    catch(error const &e)
+    {
+        setError(e.message());
+
+        if (_client != nullptr)
+            close();
+
+        return false;
+    }
+}
+
+// Let the callback play out what is still queued
+void Audio_JACK::drain()
+{
+    _started = true;
+    while (!_shutdown
+        && (_head.load(std::memory_order_acquire) != _tail.load(std::memory_order_acquire)))
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(_sleepMs));
+    }
+}
+
+// Close an opened audio device, free any allocated buffers and
+// reset any variables that reflect the current state.
+void Audio_JACK::close()
+{
+    if (_client != nullptr)
+    {
+        if (_ring)
+            drain();
+        jack_deactivate(_client);
+        jack_client_close(_client);
+        outOfOrder ();
+    }
+}
+
+void Audio_JACK::reset()
+{
+    if (_client == nullptr)
+        return;
+
+    // The tail belongs to the callback, let it drop the queued frames
+    _started = false;
+    _flushTo.store(_head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    _flush.store(true, std::memory_order_release);
+}
+
+bool Audio_JACK::write(uint_least32_t size)
+{
+    if (_client == nullptr)
+    {
+        setError("Device not open.");
+        return false;
+    }
+
+    const int channels = _settings.channels;
+    const uint_least32_t frames = size / channels;
+    const uint_least32_t head = _head.load(std::memory_order_relaxed);
+
+    // Start playing once the target is queued
+    while ((head - _tail.load(std::memory_order_acquire)) + frames > _fillFrames)
+    {
+        if (_shutdown)
+        {
+            _stats.count(audioStats::FAILED_WRITES);
+            setError("JACK server shut down.");
+            return false;
+        }
+        _started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(_sleepMs));
+    }
+
+    // Copy in at most two pieces if the ring wraps
+    const uint_least32_t start = head & (_ringFrames - 1);
+    const uint_least32_t first = frames < _ringFrames - start ? frames : _ringFrames - start;
+    memcpy(_ring.get() + start * channels, _sampleBuffer, first * channels * sizeof(short));
+    memcpy(_ring.get(), _sampleBuffer + first * channels, (frames - first) * channels * sizeof(short));
+
+    _head.store(head + frames, std::memory_order_release);
+
+    // Queued frames plus what the server adds on its side
+    jack_latency_range_t range;
+    jack_port_get_latency_range(_ports[0], JackPlaybackLatency, &range);
+    const uint_least32_t queued = head + frames - _tail.load(std::memory_order_relaxed);
+    _stats.setLatency((uint_least32_t)((uint_least64_t)(queued + range.max) * 1000000 / _settings.frequency));
+
+    return true;
+}
+
+#endif // HAVE_JACK
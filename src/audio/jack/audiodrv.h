@@ -0,0 +1,95 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef AUDIO_JACK_H
+#define AUDIO_JACK_H
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef HAVE_JACK
+
+#ifndef AudioDriver
+#  define AudioDriver Audio_JACK
+#endif
+
+#include <jack/jack.h>
+
+#include <atomic>
+#include <memory>
+
+#include "../AudioBase.h"
+
+/*
+ * JACK client with one output port per channel.
+ *
+ * The emulation thread fills a single producer/single consumer ring
+ * and the realtime process callback only copies from it, without
+ * allocating or locking. The engine renders at the server rate so
+ * no resampling is needed.
+ */
+class Audio_JACK: public AudioBase
+{
+private:  // ------------------------------------------------------- private
+    static const int MAX_CHANNELS = 2;
+
+    jack_client_t *_client;
+    jack_port_t   *_ports[MAX_CHANNELS];
+
+    std::unique_ptr<short[]> _buffer;     // Rendered by the engine
+    std::unique_ptr<short[]> _ring;       // Interleaved frames
+    uint_least32_t           _ringFrames; // Power of two
+    uint_least32_t           _fillFrames; // Queued at most, the latency target
+    unsigned int             _sleepMs;
+
+    // Written by the producer only
+    std::atomic<uint_least32_t> _head;
+    // Written by the process callback only
+    std::atomic<uint_least32_t> _tail;
+
+    std::atomic<bool>           _flush;
+    std::atomic<uint_least32_t> _flushTo;  // Frames before this one are dropped
+    std::atomic<bool>           _started;  // Ring filled, starving is an xrun
+    std::atomic<bool>           _shutdown; // Server went away
+
+private:
+    void outOfOrder();
+
+    static int  process(jack_nframes_t nframes, void *arg);
+    static int  xrun(void *arg);
+    static void shutdown(void *arg);
+
+    void connectPorts();
+    void drain();
+
+public:  // --------------------------------------------------------- public
+    Audio_JACK();
+    ~Audio_JACK() override;
+
+    bool open  (AudioConfig &cfg) override;
+    void close () override;
+    void reset () override;
+    bool write (uint_least32_t size) override;
+    void pause () override { _started = false; }
+};
+
+#endif // HAVE_JACK
+#endif // AUDIO_JACK_H
@@ -112,12 +112,19 @@ bool Audio_MMSystem::open(AudioConfig &cfg)
     wfm.nAvgBytesPerSec = wfm.nSamplesPerSec * wfm.nBlockAlign;
     wfm.cbSize          = 0;
 
-    // Rev 1.3 (saw) - Calculate buffer to hold 250ms of data
-    bufSize = wfm.nSamplesPerSec / 4 * wfm.nBlockAlign;
+    // Rev 1.3 (saw) - Calculate buffer to hold 250ms of data,
+    // or a share of the latency target if given
+    bufSize = cfg.latency
+        ? cfg.msToFrames(cfg.latency) / MAXBUFBLOCKS * wfm.nBlockAlign
+        : wfm.nSamplesPerSec / 4 * wfm.nBlockAlign;
+    if (bufSize < wfm.nBlockAlign)
+        bufSize = wfm.nBlockAlign;
 
     try
     {
         cfg.bufSize = bufSize / 2;
+        cfg.latency = cfg.framesToMs(bufSize / wfm.nBlockAlign * MAXBUFBLOCKS);
+        cfg.periods = MAXBUFBLOCKS;
         checkResult(waveOutOpen(&waveHandle, WAVE_MAPPER, &wfm, 0, 0, 0));
 
         _settings = cfg;
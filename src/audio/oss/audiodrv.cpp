@@ -35,6 +35,10 @@ const char Audio_OSS::AUDIODEVICE[] = "/dev/audio";
 const char Audio_OSS::AUDIODEVICE[] = "/dev/dsp";
 #endif
 
+// Buffering when only one of latency and periods is configured
+#define DEFAULT_LATENCY_MS 200
+#define DEFAULT_PERIODS 3
+
 Audio_OSS::Audio_OSS() :
     AudioBase("OSS")
 {
@@ -74,6 +78,26 @@ bool Audio_OSS::open (AudioConfig &cfg)
             throw error("Could not open audio device.");
         }
 
+        // Fragments must be set first, the driver default is kept
+        // unless something was asked for
+        if (cfg.latency || cfg.periods)
+        {
+            const uint_least32_t latency = cfg.latency ? cfg.latency : DEFAULT_LATENCY_MS;
+            const uint_least32_t periods = cfg.periods ? cfg.periods : DEFAULT_PERIODS;
+            const uint_least32_t bytes = cfg.msToFrames(latency) / periods * cfg.channels * sizeof(short);
+
+            // Size is a power of two, from 16 bytes up
+            int shift = 4;
+            while ((shift < 16) && ((2u << shift) <= bytes))
+                shift++;
+
+            int fragment = ((periods < 0x7fff ? periods : 0x7fff) << 16) | shift;
+            if (ioctl (_audiofd, SNDCTL_DSP_SETFRAGMENT, &fragment) == (-1))
+            {
+                throw error("Could not set the fragment size.");
+            }
+        }
+
         int format = AFMT_S16_LE;
         if (ioctl (_audiofd, SNDCTL_DSP_SETFMT, &format) == (-1))
         {
@@ -103,13 +127,21 @@ bool Audio_OSS::open (AudioConfig &cfg)
             throw error("Could not set frequency.");
         }
 
+        // One fragment of samples at a time
         int temp = 0;
         ioctl (_audiofd, SNDCTL_DSP_GETBLKSIZE, &temp);
-        cfg.bufSize = (uint_least32_t) temp;
+        cfg.bufSize = (uint_least32_t) temp / sizeof(short);
+
+        audio_buf_info space;
+        if (ioctl (_audiofd, SNDCTL_DSP_GETOSPACE, &space) != (-1))
+        {
+            cfg.latency = cfg.framesToMs(space.fragstotal * space.fragsize / (cfg.channels * sizeof(short)));
+            cfg.periods = space.fragstotal;
+        }
 
         try
         {
-            _sampleBuffer = new short[cfg.bufSize];
+            _sampleBuffer = new short[cfg.bufSize]();
         }
         catch (std::bad_alloc const &ba)
         {
@@ -22,6 +22,10 @@
 
 #include <new>
 
+// Samples rendered at a time when no latency is configured
+#define DEFAULT_BUFSIZE 8192
+#define DEFAULT_PERIODS 4
+
 Audio_OUT123::Audio_OUT123() :
     AudioBase("OUT123")
 {
@@ -56,6 +60,13 @@ bool Audio_OUT123::open(AudioConfig &cfg)
             throw error("Could not init audio driver.");
         }
 
+        // Size of the device buffer, in seconds
+        if (cfg.latency
+            && (out123_param(_audiofd, OUT123_DEVICEBUFFER, 0, cfg.latency / 1000., nullptr) != 0))
+        {
+            throw error(out123_strerror(_audiofd));
+        }
+
         if (out123_open(_audiofd, nullptr, nullptr) == (-1))
         {
             throw error(out123_strerror(_audiofd));
@@ -77,11 +88,23 @@ bool Audio_OUT123::open(AudioConfig &cfg)
             throw error(out123_strerror(_audiofd));
         }
 
-        cfg.bufSize = 8192; // FIXME make configurable?
+        if (cfg.latency)
+        {
+            const uint_least32_t periods = cfg.periods ? cfg.periods : DEFAULT_PERIODS;
+            uint_least32_t frames = cfg.msToFrames(cfg.latency) / periods;
+            if (frames < 1)
+                frames = 1;
+            cfg.bufSize = frames * cfg.channels;
+            cfg.periods = periods;
+        }
+        else
+        {
+            cfg.bufSize = DEFAULT_BUFSIZE;
+        }
 
         try
         {
-            _sampleBuffer = new short[cfg.bufSize];
+            _sampleBuffer = new short[cfg.bufSize]();
         }
         catch (std::bad_alloc const &ba)
         {
@@ -24,10 +24,15 @@
 #ifdef HAVE_PULSE
 
 #include <new>
-#include <pulse/error.h>
+
+// Latency target when none is configured
+#define DEFAULT_LATENCY_MS 20
 
 Audio_Pulse::Audio_Pulse() :
-    AudioBase("PULSE")
+    AudioBase("PULSE"),
+    _mainloop(nullptr),
+    _context(nullptr),
+    _stream(nullptr)
 {
     outOfOrder();
 }
@@ -43,6 +48,38 @@ void Audio_Pulse::outOfOrder()
     clearError();
 }
 
+// The callbacks run on the mainloop thread and wake up whoever waits
+
+void Audio_Pulse::contextState(pa_context *, void *userdata)
+{
+    Audio_Pulse *self = static_cast<Audio_Pulse*>(userdata);
+    pa_threaded_mainloop_signal(self->_mainloop, 0);
+}
+
+void Audio_Pulse::streamNotify(pa_stream *, void *userdata)
+{
+    Audio_Pulse *self = static_cast<Audio_Pulse*>(userdata);
+    pa_threaded_mainloop_signal(self->_mainloop, 0);
+}
+
+void Audio_Pulse::streamRequest(pa_stream *, size_t, void *userdata)
+{
+    Audio_Pulse *self = static_cast<Audio_Pulse*>(userdata);
+    pa_threaded_mainloop_signal(self->_mainloop, 0);
+}
+
+void Audio_Pulse::streamUnderflow(pa_stream *, void *userdata)
+{
+    Audio_Pulse *self = static_cast<Audio_Pulse*>(userdata);
+    self->_stats.count(audioStats::XRUNS);
+}
+
+void Audio_Pulse::streamError(const char *msg)
+{
+    _stats.count(audioStats::FAILED_WRITES);
+    setError(msg);
+}
+
 bool Audio_Pulse::open(AudioConfig &cfg)
 {
     pa_sample_spec pacfg = {};
@@ -51,31 +88,95 @@ bool Audio_Pulse::open(AudioConfig &cfg)
     pacfg.rate = cfg.frequency;
     pacfg.format = PA_SAMPLE_S16NE;
 
-    // Set sample precision and type of encoding.
-    int err;
-    _audioHandle = pa_simple_new(
-        nullptr,
-        "sidplayfp",
-        PA_STREAM_PLAYBACK,
-        nullptr,
-        "sidplayfp",
-        &pacfg,
-        nullptr,
-        nullptr,
-        &err
-    );
+    bool locked = false;
 
     try
     {
-        if (! _audioHandle) {
-            throw error(pa_strerror(err));
+        if (_mainloop != nullptr)
+        {
+            throw error("Device already in use");
+        }
+
+        _mainloop = pa_threaded_mainloop_new();
+        if (!_mainloop)
+            throw error("Unable to create the mainloop.");
+
+        _context = pa_context_new(pa_threaded_mainloop_get_api(_mainloop), "sidplayfp");
+        if (!_context)
+            throw error("Unable to create the context.");
+        pa_context_set_state_callback(_context, contextState, this);
+
+        if (pa_context_connect(_context, nullptr, PA_CONTEXT_NOFLAGS, nullptr) < 0)
+            throw error(pa_strerror(pa_context_errno(_context)));
+
+        pa_threaded_mainloop_lock(_mainloop);
+        locked = true;
+
+        if (pa_threaded_mainloop_start(_mainloop) < 0)
+            throw error("Unable to start the mainloop.");
+
+        for (;;)
+        {
+            const pa_context_state_t state = pa_context_get_state(_context);
+            if (state == PA_CONTEXT_READY)
+                break;
+            if (!PA_CONTEXT_IS_GOOD(state))
+                throw error(pa_strerror(pa_context_errno(_context)));
+            pa_threaded_mainloop_wait(_mainloop);
+        }
+
+        _stream = pa_stream_new(_context, "sidplayfp", &pacfg, nullptr);
+        if (!_stream)
+            throw error(pa_strerror(pa_context_errno(_context)));
+        pa_stream_set_state_callback(_stream, streamNotify, this);
+        pa_stream_set_write_callback(_stream, streamRequest, this);
+        pa_stream_set_underflow_callback(_stream, streamUnderflow, this);
+
+        // Let the server pick everything but the target length
+        // and, if asked for, the request size
+        const uint_least32_t latency = cfg.latency ? cfg.latency : DEFAULT_LATENCY_MS;
+        pa_buffer_attr attr;
+        attr.maxlength = (uint32_t) -1;
+        attr.tlength   = pa_usec_to_bytes((pa_usec_t)latency * PA_USEC_PER_MSEC, &pacfg);
+        attr.prebuf    = (uint32_t) -1;
+        attr.minreq    = cfg.periods ? attr.tlength / cfg.periods : (uint32_t) -1;
+        attr.fragsize  = (uint32_t) -1;
+
+        const pa_stream_flags_t flags = static_cast<pa_stream_flags_t>(
+            PA_STREAM_ADJUST_LATENCY | PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_INTERPOLATE_TIMING);
+        if (pa_stream_connect_playback(_stream, nullptr, &attr, flags, nullptr, nullptr) < 0)
+            throw error(pa_strerror(pa_context_errno(_context)));
+
+        for (;;)
+        {
+            const pa_stream_state_t state = pa_stream_get_state(_stream);
+            if (state == PA_STREAM_READY)
+                break;
+            if (!PA_STREAM_IS_GOOD(state))
+                throw error(pa_strerror(pa_context_errno(_context)));
+            pa_threaded_mainloop_wait(_mainloop);
+        }
+
+        // Render as much as the server asks for at a time
+        const pa_buffer_attr *actual = pa_stream_get_buffer_attr(_stream);
+        cfg.bufSize = (actual && (actual->minreq >= 2 * sizeof(short) * cfg.channels))
+            ? actual->minreq / sizeof(short)
+            : 4096;
+        cfg.bufSize -= cfg.bufSize % cfg.channels;
+
+        if (actual)
+        {
+            const uint_least32_t frameBytes = pa_frame_size(&pacfg);
+            cfg.latency = cfg.framesToMs(actual->tlength / frameBytes);
+            cfg.periods = actual->minreq ? actual->tlength / actual->minreq : 0;
         }
 
-        cfg.bufSize = 4096;
+        pa_threaded_mainloop_unlock(_mainloop);
+        locked = false;
 
         try
         {
-            _sampleBuffer = new short[cfg.bufSize];
+            _sampleBuffer = new short[cfg.bufSize]();
         }
         catch (std::bad_alloc const &ba)
         {
@@ -90,9 +191,9 @@ bool Audio_Pulse::open(AudioConfig &cfg)
     {
         setError(e.message());
 
-        if (_audioHandle)
-            pa_simple_free(_audioHandle);
-        _audioHandle = nullptr;
+        if (locked)
+            pa_threaded_mainloop_unlock(_mainloop);
+        close();
 
         return false;
     }
@@ -102,10 +203,27 @@ bool Audio_Pulse::open(AudioConfig &cfg)
 // reset any variables that reflect the current state.
 void Audio_Pulse::close()
 {
-    if (_audioHandle != nullptr)
+    if (_mainloop != nullptr)
+        pa_threaded_mainloop_stop(_mainloop);
+
+    if (_stream != nullptr)
+    {
+        pa_stream_disconnect(_stream);
+        pa_stream_unref(_stream);
+        _stream = nullptr;
+    }
+
+    if (_context != nullptr)
+    {
+        pa_context_disconnect(_context);
+        pa_context_unref(_context);
+        _context = nullptr;
+    }
+
+    if (_mainloop != nullptr)
     {
-        pa_simple_free(_audioHandle);
-        _audioHandle = nullptr;
+        pa_threaded_mainloop_free(_mainloop);
+        _mainloop = nullptr;
     }
 
     if (_sampleBuffer != nullptr)
@@ -115,20 +233,73 @@ void Audio_Pulse::close()
     }
 }
 
+// Drop what is queued on the server
+void Audio_Pulse::reset()
+{
+    if (_stream == nullptr)
+        return;
+
+    pa_threaded_mainloop_lock(_mainloop);
+    pa_operation *op = pa_stream_flush(_stream, nullptr, nullptr);
+    if (op)
+        pa_operation_unref(op);
+    pa_threaded_mainloop_unlock(_mainloop);
+}
+
 bool Audio_Pulse::write(uint_least32_t size)
 {
-    if (_audioHandle == nullptr)
+    if (_stream == nullptr)
     {
         setError("Device not open.");
         return false;
     }
 
-    int err;
-    if (pa_simple_write(_audioHandle, _sampleBuffer, size * 2, &err) < 0)
+    const char *data = reinterpret_cast<const char*>(_sampleBuffer);
+    size_t bytes = size * sizeof(short);
+
+    pa_threaded_mainloop_lock(_mainloop);
+
+    while (bytes)
     {
-        setError(pa_strerror(err));
-        // FIXME should we return false here?
+        if (!PA_STREAM_IS_GOOD(pa_stream_get_state(_stream)))
+        {
+            streamError(pa_strerror(pa_context_errno(_context)));
+            pa_threaded_mainloop_unlock(_mainloop);
+            return false;
+        }
+
+        const size_t writable = pa_stream_writable_size(_stream);
+        if (writable == (size_t) -1)
+        {
+            streamError(pa_strerror(pa_context_errno(_context)));
+            pa_threaded_mainloop_unlock(_mainloop);
+            return false;
+        }
+
+        // Wait for the server to ask for more
+        if (writable == 0)
+        {
+            pa_threaded_mainloop_wait(_mainloop);
+            continue;
+        }
+
+        const size_t chunk = (writable < bytes) ? writable : bytes;
+        if (pa_stream_write(_stream, data, chunk, nullptr, 0, PA_SEEK_RELATIVE) < 0)
+        {
+            streamError(pa_strerror(pa_context_errno(_context)));
+            pa_threaded_mainloop_unlock(_mainloop);
+            return false;
+        }
+        data  += chunk;
+        bytes -= chunk;
     }
+
+    pa_usec_t latency;
+    int negative;
+    if (pa_stream_get_latency(_stream, &latency, &negative) == 0)
+        _stats.setLatency(negative ? 0 : (uint_least32_t)latency);
+
+    pa_threaded_mainloop_unlock(_mainloop);
     return true;
 }
 
@@ -31,23 +31,39 @@
 #  define AudioDriver Audio_Pulse
 #endif
 
-#include <pulse/simple.h>
+#include <pulse/pulseaudio.h>
 
 #include "../AudioBase.h"
 
+/*
+ * Playback stream on the asynchronous API. The server runs its own
+ * thread through a threaded mainloop, writes wait until the server
+ * asks for more data and the buffer attributes follow the latency
+ * target.
+ */
 class Audio_Pulse: public AudioBase
 {
 private:  // ------------------------------------------------------- private
-    pa_simple *_audioHandle;
+    pa_threaded_mainloop *_mainloop;
+    pa_context *_context;
+    pa_stream *_stream;
+
     void outOfOrder ();
 
+    static void contextState(pa_context *context, void *userdata);
+    static void streamNotify(pa_stream *stream, void *userdata);
+    static void streamRequest(pa_stream *stream, size_t bytes, void *userdata);
+    static void streamUnderflow(pa_stream *stream, void *userdata);
+
+    void streamError(const char *msg);
+
 public:  // --------------------------------------------------------- public
     Audio_Pulse();
     ~Audio_Pulse();
 
     bool open  (AudioConfig &cfg) override;
     void close () override;
-    void reset () override {}
+    void reset () override;
     bool write (uint_least32_t size) override;
     void pause () override {}
 };
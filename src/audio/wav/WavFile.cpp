@@ -22,14 +22,25 @@
  */
 
 #include "WavFile.h"
+#include "../SampleConvert.h"
 
-#include <vector>
 #include <iomanip>
 #include <fstream>
 #include <new>
 
 #include <cstring>
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#if defined(HAVE_SYS_MMAN_H) && (defined(HAVE_FALLOCATE) || defined(HAVE_POSIX_FALLOCATE))
+#  define WAV_MMAP
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
 // Get the lo byte (8 bit) in a dword (32 bit)
 inline uint8_t endian_32lo8 (uint_least32_t dword)
 {
@@ -126,9 +137,27 @@ WavFile::WavFile(const std::string &name) :
     file(nullptr),
     headerWritten(false),
     hasListInfo(false),
-    precision(32)
+    precision(32),
+    scratch(nullptr),
+    expectedLength(0),
+    fd(-1),
+    map(nullptr),
+    mapSize(0),
+    mapPos(0),
+    direct(false)
 {}
 
+unsigned long WavFile::headerSize() const
+{
+    return sizeof(riffHeader) + (hasListInfo ? sizeof(listInfo) : 0) + sizeof(wavHeader);
+}
+
+void WavFile::updateHeader()
+{
+    endian_little32(riffHdr.length, headerSize()-8+dataSize);
+    endian_little32(wavHdr.dataChunkLen, dataSize);
+}
+
 bool WavFile::open(AudioConfig &cfg)
 {
     precision = cfg.precision;
@@ -144,32 +173,42 @@ bool WavFile::open(AudioConfig &cfg)
     if (name.empty())
         return false;
 
-    if (file && !file->fail())
+    if (file || map)
         close();
 
+    clearError();
     dataSize = 0;
 
+    // Fill in header with parameters and expected file size.
+    endian_little32(riffHdr.length, headerSize()-8);
+    endian_little16(wavHdr.channels, channels);
+    endian_little16(wavHdr.format, format);
+    endian_little32(wavHdr.sampleFreq, freq);
+    endian_little32(wavHdr.bytesPerSec, freq*blockAlign);
+    endian_little16(wavHdr.blockAlign, blockAlign);
+    endian_little16(wavHdr.bitsPerSample, bits);
+    endian_little32(wavHdr.dataChunkLen, 0);
+
+    if (expectedLength && (name.compare("-") != 0) && openMapped(cfg))
+    {
+        _settings = cfg;
+        return true;
+    }
+
     // We need to make a buffer for the user
     try
     {
         _sampleBuffer = new short[bufSize];
+        scratch = new char[sampleConvert::scratchSize(bufSize)];
     }
     catch (std::bad_alloc const &ba)
     {
+        delete[] _sampleBuffer;
+        _sampleBuffer = nullptr;
         setError("Unable to allocate memory for sample buffers.");
         return false;
     }
 
-    // Fill in header with parameters and expected file size.
-    endian_little32(riffHdr.length, sizeof(riffHeader)+sizeof(wavHeader)-8);
-    endian_little16(wavHdr.channels, channels);
-    endian_little16(wavHdr.format, format);
-    endian_little32(wavHdr.sampleFreq, freq);
-    endian_little32(wavHdr.bytesPerSec, freq*blockAlign);
-    endian_little16(wavHdr.blockAlign, blockAlign);
-    endian_little16(wavHdr.bitsPerSample, bits);
-    endian_little32(wavHdr.dataChunkLen, 0);
-
     if (name.compare("-") == 0)
     {
         file = &std::cout;
@@ -177,70 +216,270 @@ bool WavFile::open(AudioConfig &cfg)
     else
     {
         file = new std::ofstream(name.c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+        if (file->fail())
+        {
+            setError("Unable to open output file.");
+            delete file;
+            file = nullptr;
+            delete[] _sampleBuffer;
+            _sampleBuffer = nullptr;
+            delete[] scratch;
+            scratch = nullptr;
+            return false;
+        }
     }
 
+    writer.start(file);
+
     _settings = cfg;
     return true;
 }
 
+#ifdef WAV_MMAP
+
+/**
+ * Lay out the whole file in advance and map it. 16 bit samples
+ * are then rendered in place, floats are converted into the map.
+ * Returns false to fall back to the stream.
+ */
+bool WavFile::openMapped(const AudioConfig &cfg)
+{
+    const unsigned int bytes = precision >> 3;
+    const uint_least64_t samples = (uint_least64_t)expectedLength * cfg.frequency / 1000 * cfg.channels;
+
+    fd = ::open(name.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0666);
+    if (fd < 0)
+        return false;
+
+#ifdef WORDS_BIGENDIAN
+    direct = false;
+#else
+    direct = precision == 16;
+#endif
+
+    // Room for the whole tune plus a buffer, in case it runs over
+    mapPos = headerSize();
+    if (!growMap(mapPos + (samples + cfg.bufSize) * bytes))
+    {
+        closeMapped();
+        return false;
+    }
+
+    if (!direct)
+    {
+        try
+        {
+            _sampleBuffer = new short[cfg.bufSize];
+        }
+        catch (std::bad_alloc const &ba)
+        {
+            closeMapped();
+            return false;
+        }
+    }
+
+    // Header with the expected size, fixed on close if different
+    dataSize = samples * bytes;
+    updateHeader();
+    char *header = map;
+    memcpy(header, &riffHdr, sizeof(riffHeader));
+    header += sizeof(riffHeader);
+    if (hasListInfo)
+    {
+        memcpy(header, &listHdr, sizeof(listInfo));
+        header += sizeof(listInfo);
+    }
+    memcpy(header, &wavHdr, sizeof(wavHeader));
+    dataSize = 0;
+
+    if (direct)
+        _sampleBuffer = reinterpret_cast<short*>(map + mapPos);
+
+    return true;
+}
+
+bool WavFile::growMap(size_t size)
+{
+    if (size <= mapSize)
+        return true;
+
+    // Grow by half as much again at least
+    if (mapSize && (size < mapSize + mapSize / 2))
+        size = mapSize + mapSize / 2;
+
+    bool reserved = false;
+#  ifdef HAVE_FALLOCATE
+    reserved = fallocate(fd, 0, mapSize, size - mapSize) == 0;
+#  endif
+#  ifdef HAVE_POSIX_FALLOCATE
+    if (!reserved)
+        reserved = posix_fallocate(fd, mapSize, size - mapSize) == 0;
+#  endif
+    if (!reserved)
+        return false;
+
+    if (map)
+        munmap(map, mapSize);
+    void *addr = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        map = nullptr;
+        mapSize = 0;
+        return false;
+    }
+    map = static_cast<char*>(addr);
+    mapSize = size;
+    return true;
+}
+
+bool WavFile::writeMapped(uint_least32_t size)
+{
+    const unsigned long bytes = size * (precision >> 3);
+
+    if (!direct)
+    {
+        if (!growMap(mapPos + bytes))
+        {
+            setError("Unable to extend output file.");
+            return false;
+        }
+
+        char *dest = map + mapPos;
+        const void *data = (precision == 16)
+            ? sampleConvert::toS16LE(_sampleBuffer, dest, size)
+            : sampleConvert::toF32LE(_sampleBuffer, dest, size);
+        if (data != dest)
+            memcpy(dest, data, bytes);
+    }
+
+    mapPos   += bytes;
+    dataSize += bytes;
+
+    if (direct)
+    {
+        // Next buffer right after this one
+        if (!growMap(mapPos + _settings.bufSize * 2))
+        {
+            setError("Unable to extend output file.");
+            return false;
+        }
+        _sampleBuffer = reinterpret_cast<short*>(map + mapPos);
+    }
+    return true;
+}
+
+void WavFile::closeMapped()
+{
+    if (map)
+    {
+        // The header is in place, only the lengths may differ
+        updateHeader();
+        memcpy(map, &riffHdr, sizeof(riffHeader));
+        memcpy(map + headerSize() - sizeof(wavHeader), &wavHdr, sizeof(wavHeader));
+        munmap(map, mapSize);
+        map = nullptr;
+        mapSize = 0;
+
+        // Release what was reserved but not used
+        if (ftruncate(fd, mapPos) != 0)
+            setError("Unable to truncate output file.");
+    }
+
+    if (fd >= 0)
+    {
+        if (::close(fd) != 0)
+            setError("Unable to write output file.");
+        fd = -1;
+    }
+
+    if (!direct)
+        delete[] _sampleBuffer;
+    _sampleBuffer = nullptr;
+    direct = false;
+}
+
+#else
+
+bool WavFile::openMapped(const AudioConfig &) { return false; }
+bool WavFile::writeMapped(uint_least32_t) { return false; }
+void WavFile::closeMapped() {}
+
+#endif // WAV_MMAP
+
 bool WavFile::write(uint_least32_t size)
 {
-    if (file && !file->fail())
+    if (map)
+        return writeMapped(size);
+
+    if (file && !writer.failed())
     {
         unsigned long int bytes = size;
         if (!headerWritten)
         {
-            file->write((char*)&riffHdr, sizeof(riffHeader));
+            writer.write(&riffHdr, sizeof(riffHeader));
             if (hasListInfo)
-                file->write((char*)&listHdr, sizeof(listInfo));
-            file->write((char*)&wavHdr, sizeof(wavHeader));
+                writer.write(&listHdr, sizeof(listInfo));
+            writer.write(&wavHdr, sizeof(wavHeader));
             headerWritten = true;
         }
 
-        /* XXX endianness... */
+        const void *data;
         if (precision == 16)
         {
             bytes *= 2;
-            file->write((char*)_sampleBuffer, bytes);
+            data = sampleConvert::toS16LE(_sampleBuffer, scratch, size);
         }
         else
         {
-            std::vector<float> buffer(size);
             bytes *= 4;
-            // normalize floats
-            for (unsigned long i=0; i<size; i++)
-            {
-                buffer[i] = ((float)_sampleBuffer[i])/32768.f;
-            }
-            file->write((char*)&buffer.front(), bytes);
+            data = sampleConvert::toF32LE(_sampleBuffer, scratch, size);
         }
+        writer.write(data, bytes);
         dataSize += bytes;
+        return !writer.failed();
     }
-    return true;
+    return false;
 }
 
 void WavFile::close()
 {
-    if (file && !file->fail())
+    if (map)
+    {
+        closeMapped();
+        return;
+    }
+
+    if (file == nullptr)
+        return;
+
+    // Let the queued data reach the file
+    if (!writer.finish())
+        setError("Unable to write output file.");
+
+    if (file != &std::cout)
     {
-        // update length fields in header
-        unsigned long int headerSize = sizeof(riffHeader)+sizeof(wavHeader)-8;
-        if (hasListInfo)
-            headerSize += sizeof(listInfo);
-        endian_little32(riffHdr.length, headerSize+dataSize);
-        endian_little32(wavHdr.dataChunkLen, dataSize);
-        if (file != &std::cout)
+        if (!file->fail())
         {
+            // update length fields in header
+            updateHeader();
             file->seekp(0, std::ios::beg);
             file->write((char*)&riffHdr, sizeof(riffHeader));
             if (hasListInfo)
                 file->write((char*)&listHdr, sizeof(listInfo));
             file->write((char*)&wavHdr, sizeof(wavHeader));
-            delete file;
         }
-        file = nullptr;
-        delete[] _sampleBuffer;
+
+        // The final flush can still fail, on a full disk for example
+        static_cast<std::ofstream*>(file)->close();
+        if (file->fail())
+            setError("Unable to write output file.");
+        delete file;
     }
+    file = nullptr;
+    delete[] _sampleBuffer;
+    _sampleBuffer = nullptr;
+    delete[] scratch;
+    scratch = nullptr;
 }
 
 void WavFile::setInfo(const char* title, const char* author, const char* released)
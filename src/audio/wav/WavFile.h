@@ -28,6 +28,7 @@
 #include <string>
 
 #include "../AudioBase.h"
+#include "../FileWriter.h"
 
 struct riffHeader                       // little endian format
 {
@@ -98,6 +99,27 @@ private:
     bool hasListInfo;
     int precision;
 
+    char *scratch; // Converted samples
+
+    fileWriter writer;
+
+    // Memory mapped output, used when the length is known
+    uint_least32_t expectedLength; // In milliseconds
+    int    fd;
+    char  *map;
+    size_t mapSize;
+    size_t mapPos;
+    bool   direct;                 // Samples are rendered into the map
+
+private:
+    unsigned long headerSize() const;
+    void updateHeader();
+
+    bool openMapped(const AudioConfig &cfg);
+    bool growMap(size_t size);
+    bool writeMapped(uint_least32_t size);
+    void closeMapped();
+
 public:
     WavFile(const std::string &name);
     ~WavFile() override { close(); }
@@ -124,6 +146,12 @@ public:
     bool bad()  const { return (file->bad()  != 0); }
 
     void setInfo(const char* title, const char* author, const char* released);
+
+    /**
+     * Set the play length, if known. The file is then allocated
+     * in advance and memory mapped where supported.
+     */
+    void setLength(uint_least32_t ms) { expectedLength = ms; }
 };
 
 #endif /* WAV_FILE_H */
@@ -0,0 +1,588 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "player.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <thread>
+
+using std::cerr;
+using std::endl;
+
+#include "audio/au/auFile.h"
+#include "audio/flac/FlacFile.h"
+#include "audio/wav/WavFile.h"
+
+#include <sidplayfp/sidbuilder.h>
+#include <sidplayfp/SidTuneInfo.h>
+
+// Wide-chars are not yet supported here
+#undef SEPARATOR
+#define SEPARATOR "/"
+
+/*
+ * Batch rendering.
+ *
+ * Every worker owns a complete engine and renders whole files,
+ * one subtune at a time, straight to its own file sink.
+ * Configuration, ROMs and the songlength database are loaded once
+ * by the main thread and only read by the workers.
+ *
+ * Finished jobs can be recorded in an append-only journal, one
+ * "md5 subtune config" line each, so that an interrupted batch
+ * picks up where it stopped. Outputs are written to a temporary
+ * file and renamed when complete so a journaled job always has
+ * its file in place.
+ *
+ * When rendering stems the files are taken one at a time and the
+ * workers split the stems of each subtune instead, every one with
+ * the other voices muted. They all start from the same power on
+ * delay and render the same number of samples, so the stems line
+ * up sample by sample.
+ */
+
+// Hash of the settings that change the rendered output
+std::string ConsolePlayer::configHash() const
+{
+    std::ostringstream settings;
+    settings << m_engCfg.frequency << ' ' << m_engCfg.samplingMethod << ' ' << m_engCfg.fastSampling
+             << ' ' << m_engCfg.defaultC64Model << ' ' << m_engCfg.forceC64Model
+             << ' ' << m_engCfg.defaultSidModel << ' ' << m_engCfg.forceSidModel
+#ifdef FEAT_CONFIG_CIAMODEL
+             << ' ' << m_engCfg.ciaModel
+#endif
+#ifdef FEAT_DIGIBOOST
+             << ' ' << m_engCfg.digiBoost
+#endif
+             << ' ' << m_engCfg.powerOnDelay
+             << ' ' << m_engCfg.secondSidAddress
+#ifdef FEAT_THIRD_SID
+             << ' ' << m_engCfg.thirdSidAddress
+#endif
+             << ' ' << m_driver.sid << ' ' << m_driver.output << ' ' << m_driver.info
+             << ' ' << m_channels << ' ' << m_precision
+             << ' ' << m_filter.enabled << ' ' << m_filter.bias
+             << ' ' << m_filter.filterCurve6581 << ' ' << m_filter.filterCurve8580
+#ifdef FEAT_FILTER_RANGE
+             << ' ' << m_filter.filterRange6581
+#endif
+#ifdef FEAT_CW_STRENGTH
+             << ' ' << m_combinedWaveformsStrength
+#endif
+             << ' ' << m_fcurve << ' ' << m_autofilter << ' ' << m_batch.stems
+             << ' ' << m_timer.start << ' ' << m_timer.length << ' ' << m_timer.valid
+             << ' ' << (m_outfile ? m_outfile : "");
+    for (int i = 0; i < 9; i++)
+        settings << ' ' << vMute[i];
+
+    // FNV-1a
+    uint_least64_t hash = 0xcbf29ce484222325ULL;
+    for (const char c : settings.str())
+    {
+        hash ^= (uint8_t)c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    std::ostringstream hex;
+    hex << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return hex.str();
+}
+
+bool ConsolePlayer::openJournal()
+{
+    bool terminated = true;
+
+    {   // Collect the jobs done by previous runs
+        std::ifstream in(m_batch.journal);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            terminated = !in.eof();
+            m_batch.done.insert(line);
+        }
+    }
+
+    m_batch.journalFile.open(m_batch.journal, std::ios::out | std::ios::app);
+    if (!m_batch.journalFile.is_open())
+    {
+        displayError ("ERROR: Could not open journal");
+        return false;
+    }
+
+    // Don't append to a line cut short by a crash
+    if (!terminated)
+        m_batch.journalFile << endl;
+    return true;
+}
+
+bool ConsolePlayer::batch()
+{
+    const unsigned int files = m_batch.files.size();
+    const bool stems = m_batch.stems != STEMS_NONE;
+    const unsigned int jobs = stems ? m_batch.jobs : std::min(m_batch.jobs, files);
+
+    m_batch.next    = 0;
+    m_batch.failed  = 0;
+    m_batch.skipped = 0;
+    m_cancel        = false;
+    m_batch.config  = configHash();
+    m_batch.outputs.clear();
+
+    if (m_batch.journal && !openJournal())
+        return false;
+
+    m_state = playerRunning;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Stems bring their own workers
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < (stems ? 1 : jobs); i++)
+        workers.emplace_back(&ConsolePlayer::batchWorker, this);
+
+    for (std::thread &worker : workers)
+        worker.join();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    // Interrupted by the user
+    if (m_cancel)
+    {
+        displayError ("Batch aborted");
+        return false;
+    }
+
+    if (m_quietLevel < 2)
+    {
+        const unsigned int failed = m_batch.failed;
+        cerr << "Rendered " << (files - failed) << " of " << files << " files in "
+             << std::setprecision(1) << std::fixed << elapsed.count() << "s using "
+             << jobs << (jobs == 1 ? " thread" : " threads");
+        if (m_batch.skipped)
+            cerr << ", " << m_batch.skipped << " jobs skipped";
+        cerr << endl;
+    }
+
+    m_state = playerExit;
+    return m_batch.failed == 0;
+}
+
+void ConsolePlayer::batchWorker()
+{
+    sidplayfp engine;
+    engine.setRoms(m_kernalRom.get(), m_basicRom.get(), m_chargenRom.get());
+
+    while (!m_cancel)
+    {
+        const unsigned int i = m_batch.next++;
+        if (i >= m_batch.files.size())
+            break;
+
+        if (!batchFile(engine, m_batch.files[i]))
+            m_batch.failed++;
+    }
+}
+
+bool ConsolePlayer::batchFile(sidplayfp &engine, const std::string &fileName)
+{
+    SidTune tune(nullptr);
+
+    tune.load(fileName.c_str());
+    if (!tune.getStatus())
+    {
+        const std::string errorString(tune.statusString());
+
+        // Try prepending HVSC_BASE
+        const char* hvscBase = getenv("HVSC_BASE");
+        if (hvscBase)
+        {
+            std::string newFileName(hvscBase);
+            newFileName.append(SEPARATOR).append(fileName);
+            tune.load(newFileName.c_str());
+        }
+
+        if (!tune.getStatus())
+        {
+            std::lock_guard<std::mutex> lock(m_batch.lock);
+            cerr << m_name << ": " << fileName << ": " << errorString << endl;
+            return false;
+        }
+    }
+
+    char md5[SidTune::MD5_LENGTH + 1];
+#ifdef FEAT_NEW_SONLEGTH_DB
+    tune.createMD5New(md5);
+#else
+    tune.createMD5(md5);
+#endif
+
+    // Split by content so every machine agrees whatever the file list
+    if ((m_batch.shards > 1)
+        && ((strtoul(std::string(md5, 8).c_str(), nullptr, 16) % m_batch.shards) != (m_batch.shard - 1)))
+    {
+        return true;
+    }
+
+    // Same track selection as for a single file
+    const unsigned int songs = tune.getInfo()->songs();
+    const unsigned int first = tune.selectSong(m_track.first);
+    const unsigned int count = m_track.single ? 1 : songs;
+
+    for (unsigned int n = 0; (n < count) && !m_cancel; n++)
+    {
+        const unsigned int song = ((first - 1 + n) % songs) + 1;
+
+        std::ostringstream job;
+        job << md5 << ' ' << song << ' ' << m_batch.config;
+
+        if (m_batch.journal)
+        {
+            std::lock_guard<std::mutex> lock(m_batch.lock);
+            if (m_batch.done.count(job.str()))
+            {
+                m_batch.skipped++;
+                continue;
+            }
+        }
+
+        tune.selectSong(song);
+        if (m_batch.stems != STEMS_NONE)
+        {
+            if (!batchStems(tune))
+                return false;
+        }
+        else if (!batchSong(engine, tune, vMute, ""))
+            return false;
+
+        if (m_batch.journal)
+        {
+            std::lock_guard<std::mutex> lock(m_batch.lock);
+            m_batch.journalFile << job.str() << endl;
+        }
+    }
+
+    return true;
+}
+
+// Render the stems of the selected subtune in parallel
+bool ConsolePlayer::batchStems(SidTune &tune)
+{
+    struct stem_t
+    {
+        bool        mute[9];
+        std::string suffix;
+    };
+
+    // Extra chips may be forced from the command line
+    unsigned int chips = tune.getInfo()->sidChips();
+    if (m_engCfg.secondSidAddress && (chips < 2))
+        chips = 2;
+#ifdef FEAT_THIRD_SID
+    if (m_engCfg.thirdSidAddress && (chips < 3))
+        chips = 3;
+#endif
+
+    std::vector<stem_t> stems;
+    for (unsigned int chip = 0; chip < chips; chip++)
+    {
+        if (m_batch.stems == STEMS_CHIPS)
+        {
+            stem_t stem;
+            for (unsigned int i = 0; i < 9; i++)
+                stem.mute[i] = (i / 3 != chip) || vMute[i];
+            stem.suffix = "-sid" + std::to_string(chip + 1);
+            stems.push_back(stem);
+            continue;
+        }
+
+        for (unsigned int voice = chip * 3; voice < chip * 3 + 3; voice++)
+        {
+            // Voices muted by the user are left out
+            if (vMute[voice])
+                continue;
+
+            stem_t stem;
+            for (unsigned int i = 0; i < 9; i++)
+                stem.mute[i] = i != voice;
+            stem.suffix = "-voice" + std::to_string(voice + 1);
+            stems.push_back(stem);
+        }
+    }
+
+    std::atomic<unsigned int> next(0);
+    std::atomic<unsigned int> failed(0);
+
+    // The tune is loaded once and only read by the workers
+    auto worker = [this, &tune, &stems, &next, &failed]()
+    {
+        sidplayfp engine;
+        engine.setRoms(m_kernalRom.get(), m_basicRom.get(), m_chargenRom.get());
+
+        while (!m_cancel)
+        {
+            const unsigned int i = next++;
+            if (i >= stems.size())
+                break;
+
+            if (!batchSong(engine, tune, stems[i].mute, stems[i].suffix.c_str()))
+                failed++;
+        }
+    };
+
+    const unsigned int jobs = std::min<unsigned int>(m_batch.jobs, stems.size());
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < jobs; i++)
+        workers.emplace_back(worker);
+
+    for (std::thread &thread : workers)
+        thread.join();
+
+    return (failed == 0) && !m_cancel;
+}
+
+bool ConsolePlayer::batchSong(sidplayfp &engine, SidTune &tune, const bool mute[9], const char *suffix)
+{
+    const SidTuneInfo *tuneInfo = tune.getInfo();
+
+    auto report = [this, tuneInfo](const char *error)
+    {
+        std::lock_guard<std::mutex> lock(m_batch.lock);
+        cerr << m_name << ": " << tuneInfo->dataFileName()
+             << " [" << tuneInfo->currentSong() << "]: " << error << endl;
+    };
+
+    // Stems load the same tune from several threads
+    std::unique_lock<std::mutex> tuneLock(m_batch.tuneLock, std::defer_lock);
+    if (m_batch.stems != STEMS_NONE)
+        tuneLock.lock();
+
+    if (!engine.load(&tune))
+    {
+        report(engine.error());
+        return false;
+    }
+
+    AudioConfig audioCfg;
+    audioCfg.frequency = m_engCfg.frequency;
+    audioCfg.channels  = m_channels ? m_channels : ((tuneInfo->sidChips() > 1) ? 2 : 1);
+    audioCfg.precision = m_precision;
+    audioCfg.bufSize   = 0;
+
+    if ((audioCfg.channels != 1) && (audioCfg.channels != 2))
+    {
+        report("ERROR: audio channels not supported");
+        return false;
+    }
+
+    // Work out when to stop
+    uint_least32_t length = m_timer.length;
+    if (!m_timer.valid)
+    {
+        const int_least32_t dbLength = songLength(tune);
+        if (dbLength > 0)
+            length = dbLength;
+    }
+
+    const uint_least32_t stop = m_timer.valid ? m_timer.start + length : length;
+    if (m_timer.start >= stop)
+    {
+        report("ERROR: Start time exceeds song length!");
+        return false;
+    }
+
+    if (tuneLock.owns_lock())
+        tuneLock.unlock();
+
+    // Each worker has its own emulation
+    SidConfig cfg(m_engCfg);
+    if (!newSidEmu(m_driver.sid, tuneInfo, cfg.sidEmulation))
+        return false;
+    std::unique_ptr<sidbuilder> builder(cfg.sidEmulation);
+
+    cfg.playback = (audioCfg.channels == 1) ? SidConfig::MONO : SidConfig::STEREO;
+    if (!engine.config(cfg))
+    {
+        report(engine.error());
+        return false;
+    }
+
+    for (int i = 0; i < 9; i++)
+        engine.mute(i / 3, i % 3, mute[i]);
+
+    bool ok = true;
+
+    if (m_timer.start && !preRoll(engine, m_timer.start))
+    {
+        report(m_cancel ? "Seek cancelled" : engine.error());
+        ok = false;
+    }
+
+    const char *extension;
+    switch (m_driver.output)
+    {
+    case OUT_AU:   extension = auFile::extension();   break;
+#ifdef HAVE_FLAC
+    case OUT_FLAC: extension = FlacFile::extension(); break;
+#endif
+    default:       extension = WavFile::extension();  break;
+    }
+    std::string outName = getFileName(tuneInfo, extension);
+    if (*suffix != '\0')
+    {
+        const std::string::size_type dot = outName.find_last_of('.');
+        const std::string::size_type sep = outName.find_last_of("/\\");
+        const bool hasExt = (dot != std::string::npos) && ((sep == std::string::npos) || (dot > sep));
+        outName.insert(hasExt ? dot : outName.length(), suffix);
+    }
+
+    // Two jobs writing the same file would corrupt each other
+    if (ok && (outName.compare("-") != 0))
+    {
+        std::lock_guard<std::mutex> lock(m_batch.lock);
+        if (!m_batch.outputs.insert(outName).second)
+        {
+            ok = false;
+            cerr << m_name << ": " << tuneInfo->dataFileName() << " [" << tuneInfo->currentSong()
+                 << "]: ERROR: " << outName << " is already written by another job, use %f and %n in the output template" << endl;
+        }
+    }
+
+    // Only complete files get their final name
+    const bool rename = outName.compare("-") != 0;
+    const std::string partName = rename ? outName + ".part" : outName;
+
+    std::unique_ptr<IAudio> sink;
+    if (ok)
+    {
+        try
+        {
+            if (m_driver.output == OUT_AU)
+            {
+                sink.reset(new auFile(partName));
+            }
+#ifdef HAVE_FLAC
+            else if (m_driver.output == OUT_FLAC)
+            {
+                // Tunes are already rendered in parallel
+                FlacFile* flac = new FlacFile(partName, 1);
+                if (m_driver.info && (tuneInfo->numberOfInfoStrings() == 3))
+                    flac->setInfo(tuneInfo->infoString(0), tuneInfo->infoString(1), tuneInfo->infoString(2));
+                sink.reset(flac);
+            }
+#endif
+            else
+            {
+                WavFile* wav = new WavFile(partName);
+                if (m_driver.info && (tuneInfo->numberOfInfoStrings() == 3))
+                    wav->setInfo(tuneInfo->infoString(0), tuneInfo->infoString(1), tuneInfo->infoString(2));
+                wav->setLength(stop - m_timer.start);
+                sink.reset(wav);
+            }
+
+            if (!sink->open(audioCfg))
+            {
+                report(sink->getErrorString());
+                ok = false;
+            }
+        }
+        catch (std::bad_alloc const &ba)
+        {
+            report("ERROR: Not enough memory.");
+            ok = false;
+        }
+    }
+
+    if (ok)
+    {
+        // Count samples rather than time so the file length is exact
+        uint_least64_t left = (uint_least64_t)(stop - m_timer.start) * audioCfg.frequency / 1000
+            * audioCfg.channels;
+        const uint_least32_t chunk = std::min<uint_least32_t>(audioCfg.frequency / 10 * audioCfg.channels,
+                                                              audioCfg.bufSize);
+
+        while (left && !m_cancel)
+        {
+            const uint_least32_t size = (left < chunk) ? (uint_least32_t)left : chunk;
+            const uint_least32_t ret = engine.play(sink->buffer(), size);
+            if (ret < size)
+            {
+                report(engine.error());
+                ok = false;
+                break;
+            }
+
+            if (!sink->write(ret))
+            {
+                report(sink->getErrorString());
+                ok = false;
+                break;
+            }
+            left -= ret;
+        }
+
+        // Interrupted
+        if (left)
+            ok = false;
+
+        // A failed final flush leaves a truncated file behind
+        sink->close();
+        if (ok && (*sink->getErrorString() != '\0'))
+        {
+            report(sink->getErrorString());
+            ok = false;
+        }
+
+        if (rename)
+        {
+#ifdef _WIN32
+            if (ok)
+                std::remove(outName.c_str());
+#endif
+            if (ok && (std::rename(partName.c_str(), outName.c_str()) != 0))
+            {
+                report("ERROR: Could not rename output file");
+                ok = false;
+            }
+            if (!ok)
+                std::remove(partName.c_str());
+        }
+
+        if (ok && (m_quietLevel == 0))
+        {
+            std::lock_guard<std::mutex> lock(m_batch.lock);
+            cerr << tuneInfo->dataFileName() << " [" << tuneInfo->currentSong() << "/"
+                 << tuneInfo->songs() << "] -> " << outName << endl;
+        }
+    }
+
+    // Release the emulation before the builder goes away
+    engine.stop();
+    cfg.sidEmulation = nullptr;
+    engine.config(cfg);
+
+    return ok;
+}
@@ -0,0 +1,600 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "player.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#ifndef _WIN32
+#  include <dirent.h>
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#endif
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+#include <sidplayfp/sidbuilder.h>
+#include <sidplayfp/SidTuneInfo.h>
+
+// Wide-chars are not yet supported here
+#undef SEPARATOR
+#define SEPARATOR "/"
+
+/*
+ * Benchmark mode.
+ *
+ * Each tune is rendered for a fixed amount of audio straight into
+ * a scratch buffer, as fast as the emulation goes: no sound device,
+ * no file and no display. The real time multiple tells how many
+ * streams with the same settings a core can keep up with.
+ *
+ * The matrix mode runs the whole set of tunes through every
+ * combination of engine, sampling method, frequency, channels and
+ * number of SIDs. Each cell gets a warm-up run followed by the
+ * measured ones and the real time multiples of the runs are
+ * summarized as median and percentiles.
+ */
+
+namespace
+{
+
+std::string jsonString(const std::string &str)
+{
+    std::ostringstream out;
+    out << '"';
+    for (const char c : str)
+    {
+        switch (c)
+        {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n";  break;
+        case '\t': out << "\\t";  break;
+        default:
+            if ((unsigned char)c < 0x20)
+            {
+                char esc[8];
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out << esc;
+            }
+            else
+                out << c;
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+const char *samplingName(SidConfig::sampling_method_t method, bool fast)
+{
+    if (method == SidConfig::INTERPOLATE)
+        return fast ? "interpolate, fast" : "interpolate";
+    return fast ? "resample interpolate, fast" : "resample interpolate";
+}
+
+bool isTune(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    if (ext == nullptr)
+        return false;
+
+    std::string lower;
+    while (*++ext)
+        lower.push_back(tolower((unsigned char)*ext));
+
+    return (lower == "sid") || (lower == "psid") || (lower == "prg") || (lower == "mus");
+}
+
+#ifndef _WIN32
+// Directories already expanded, symlinks may loop back
+typedef std::set<std::pair<dev_t, ino_t>> inodes_t;
+
+// Add the tunes found in a directory and below, in a stable order
+void expandDir(const std::string &path, std::vector<std::string> &files, inodes_t &visited)
+{
+    struct stat st;
+    if ((stat(path.c_str(), &st) < 0)
+        || !visited.insert(std::make_pair(st.st_dev, st.st_ino)).second)
+        return;
+
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr)
+        return;
+
+    std::vector<std::string> entries;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (entry->d_name[0] != '.')
+            entries.push_back(entry->d_name);
+    }
+    closedir(dir);
+
+    std::sort(entries.begin(), entries.end());
+    for (const std::string &name : entries)
+    {
+        const std::string child = path + SEPARATOR + name;
+        if ((stat(child.c_str(), &st) == 0) && S_ISDIR(st.st_mode))
+            expandDir(child, files, visited);
+        else if (isTune(name.c_str()))
+            files.push_back(child);
+    }
+}
+#endif
+
+// Replace directories with the tunes they contain
+void expandFiles(const std::string &path, std::vector<std::string> &files)
+{
+#ifndef _WIN32
+    struct stat st;
+    if ((stat(path.c_str(), &st) == 0) && S_ISDIR(st.st_mode))
+    {
+        inodes_t visited;
+        expandDir(path, files, visited);
+        return;
+    }
+#endif
+    files.push_back(path);
+}
+
+struct cell_t
+{
+    SIDEMUS        emu;
+    const char*    engine;
+    SidConfig::sampling_method_t sampling;
+    bool           fast;
+    uint_least32_t frequency;
+    int            channels;
+    unsigned int   chips;
+};
+
+std::string cellName(const cell_t &cell)
+{
+    std::ostringstream out;
+    out << cell.engine
+        << '/' << ((cell.sampling == SidConfig::INTERPOLATE) ? "interpolate" : "resample")
+        << '/' << (cell.fast ? "fast" : "normal")
+        << '/' << cell.frequency
+        << '/' << ((cell.channels == 1) ? "mono" : "stereo")
+        << '/' << cell.chips << "sid";
+    return out.str();
+}
+
+double median(const std::vector<double> &sorted)
+{
+    const size_t n = sorted.size();
+    return (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.;
+}
+
+// Nearest rank
+double percentile(const std::vector<double> &sorted, unsigned int pct)
+{
+    size_t rank = (pct * sorted.size() + 99) / 100;
+    if (rank < 1)
+        rank = 1;
+    return sorted[rank - 1];
+}
+
+/*
+ * Read the medians back from a previous matrix run saved with --json.
+ * Each cell is on its own line so there's no need for a real parser.
+ */
+bool readBaseline(const char *fileName, std::map<std::string, double> &cells)
+{
+    std::ifstream in(fileName);
+    if (!in.is_open())
+        return false;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        const size_t cell = line.find("\"cell\": \"");
+        const size_t value = line.find("\"median\": ");
+        if ((cell == std::string::npos) || (value == std::string::npos))
+            continue;
+
+        const size_t start = cell + 9;
+        const size_t end = line.find('"', start);
+        if (end == std::string::npos)
+            continue;
+
+        cells[line.substr(start, end - start)] = atof(line.c_str() + value + 10);
+    }
+    return true;
+}
+
+}
+
+bool ConsolePlayer::benchSong(sidplayfp &engine, SidTune &tune, SIDEMUS emu,
+                              const SidConfig &config, int channels, bench_t &result)
+{
+    const SidTuneInfo *tuneInfo = tune.getInfo();
+
+    if (!engine.load(&tune))
+    {
+        result.error = engine.error();
+        return false;
+    }
+
+    result.channels = channels ? channels : ((tuneInfo->sidChips() > 1) ? 2 : 1);
+    result.chips    = tuneInfo->sidChips();
+
+    // Extra chips forced by the configuration
+    if ((result.chips < 2) && config.secondSidAddress)
+        result.chips = 2;
+#ifdef FEAT_THIRD_SID
+    if ((result.chips < 3) && config.secondSidAddress && config.thirdSidAddress)
+        result.chips = 3;
+#endif
+
+    SidConfig cfg(config);
+    if (!newSidEmu(emu, tuneInfo, cfg.sidEmulation))
+    {
+        result.error = "cannot create the SID emulation";
+        return false;
+    }
+    std::unique_ptr<sidbuilder> builder(cfg.sidEmulation);
+    result.builder = builder->name();
+
+    cfg.playback = (result.channels == 1) ? SidConfig::MONO : SidConfig::STEREO;
+    if (!engine.config(cfg))
+    {
+        result.error = engine.error();
+        return false;
+    }
+
+    for (int i = 0; i < 9; i++)
+        engine.mute(i / 3, i % 3, vMute[i]);
+
+    const uint_least32_t chunk = cfg.frequency / 10 * result.channels;
+    std::vector<short> buffer(chunk);
+    uint_least64_t left = (uint_least64_t)m_bench.seconds * cfg.frequency * result.channels;
+
+    const std::clock_t cpuStart = std::clock();
+    const auto start = std::chrono::steady_clock::now();
+
+    bool ok = true;
+    while (left && (m_state == playerRunning))
+    {
+        const uint_least32_t size = (left < chunk) ? (uint_least32_t)left : chunk;
+        if (engine.play(buffer.data(), size) < size)
+        {
+            result.error = engine.error();
+            ok = false;
+            break;
+        }
+        left -= size;
+    }
+
+    const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    result.wall = wall.count();
+    result.cpu  = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    result.audio = (double)m_bench.seconds - (double)left / (cfg.frequency * result.channels);
+
+    // Release the emulation before the builder goes away
+    engine.stop();
+    cfg.sidEmulation = nullptr;
+    engine.config(cfg);
+
+    return ok && !left;
+}
+
+void ConsolePlayer::benchReport(const bench_t &result, bool first) const
+{
+    const double frames = result.audio * m_engCfg.frequency;
+    const double rate = result.wall > 0. ? frames / result.wall : 0.;
+    const double realtime = result.wall > 0. ? result.audio / result.wall : 0.;
+
+    if (m_bench.json)
+    {
+        cout << (first ? "[\n  " : ",\n  ")
+             << "{\"file\": " << jsonString(result.file)
+             << ", \"song\": " << result.song
+             << ", \"builder\": " << jsonString(result.builder)
+             << ", \"sampling\": \"" << ((m_engCfg.samplingMethod == SidConfig::INTERPOLATE) ? "interpolate" : "resample")
+             << "\", \"fastSampling\": " << (m_engCfg.fastSampling ? "true" : "false")
+             << ", \"frequency\": " << m_engCfg.frequency
+             << ", \"channels\": " << result.channels
+             << ", \"chips\": " << result.chips
+             << std::setprecision(6) << std::fixed
+             << ", \"audio\": " << result.audio
+             << ", \"wall\": " << result.wall
+             << ", \"cpu\": " << result.cpu
+             << std::setprecision(1)
+             << ", \"samplesPerSecond\": " << rate
+             << std::setprecision(3)
+             << ", \"realtime\": " << realtime;
+        if (!result.error.empty())
+            cout << ", \"error\": " << jsonString(result.error);
+        cout << "}";
+        return;
+    }
+
+    cout << result.file << " [" << result.song << "]: " << result.builder << ", "
+         << samplingName(m_engCfg.samplingMethod, m_engCfg.fastSampling) << ", "
+         << m_engCfg.frequency << " Hz, " << (result.channels == 1 ? "mono" : "stereo") << ", "
+         << result.chips << (result.chips == 1 ? " SID" : " SIDs") << endl;
+    if (!result.error.empty())
+    {
+        cout << "  ERROR: " << result.error << endl;
+        return;
+    }
+    cout << std::setprecision(3) << std::fixed
+         << "  " << result.audio << "s rendered in " << result.wall << "s wall, "
+         << result.cpu << "s CPU, " << std::setprecision(0) << rate << " samples/s, "
+         << std::setprecision(1) << realtime << "x real time" << endl;
+}
+
+bool ConsolePlayer::benchMatrix(sidplayfp &engine, std::vector<std::unique_ptr<SidTune>> &tunes)
+{
+    std::map<std::string, double> baseline;
+    if (m_bench.baseline && !readBaseline(m_bench.baseline, baseline))
+    {
+        cerr << m_name << ": cannot read baseline " << m_bench.baseline << endl;
+        return false;
+    }
+
+    std::vector<std::pair<SIDEMUS, const char*>> engines;
+#ifdef HAVE_SIDPLAYFP_BUILDERS_RESIDFP_H
+    engines.push_back(std::make_pair(EMU_RESIDFP, "residfp"));
+#endif
+#ifdef HAVE_SIDPLAYFP_BUILDERS_RESID_H
+    engines.push_back(std::make_pair(EMU_RESID, "resid"));
+#endif
+
+    const SidConfig::sampling_method_t samplings[] = { SidConfig::INTERPOLATE, SidConfig::RESAMPLE_INTERPOLATE };
+    const bool fasts[] = { false, true };
+    const uint_least32_t frequencies[] = { 44100, 48000, 96000 };
+    const int channels[] = { 1, 2 };
+#ifdef FEAT_THIRD_SID
+    const unsigned int maxChips = 3;
+#else
+    const unsigned int maxChips = 2;
+#endif
+
+    std::vector<cell_t> cells;
+    for (const auto &emu : engines)
+        for (const SidConfig::sampling_method_t sampling : samplings)
+            for (const bool fast : fasts)
+                for (const uint_least32_t frequency : frequencies)
+                    for (const int ch : channels)
+                        for (unsigned int chips = 1; chips <= maxChips; chips++)
+                            cells.push_back(cell_t{ emu.first, emu.second, sampling, fast, frequency, ch, chips });
+
+    if (!m_bench.json)
+    {
+        cout << cells.size() << " cells, " << tunes.size() << " tunes, " << m_bench.seconds
+             << "s each, 1 warm-up and " << m_bench.repeat << " measured runs" << endl
+             << "Cell                                            median      p10      p90  (x real time)" << endl;
+    }
+
+    unsigned int failed = 0;
+    bool first = true;
+    for (const cell_t &cell : cells)
+    {
+        if (m_state != playerRunning)
+            break;
+
+        SidConfig cfg(m_engCfg);
+        cfg.samplingMethod   = cell.sampling;
+        cfg.fastSampling     = cell.fast;
+        cfg.frequency        = cell.frequency;
+        cfg.secondSidAddress = (cell.chips > 1) ? 0xd420 : 0;
+#ifdef FEAT_THIRD_SID
+        cfg.thirdSidAddress  = (cell.chips > 2) ? 0xd440 : 0;
+#endif
+
+        std::vector<double> runs;
+        std::string error;
+        for (unsigned int run = 0; (run <= m_bench.repeat) && error.empty(); run++)
+        {
+            double audio = 0.;
+            double wall = 0.;
+            for (std::unique_ptr<SidTune> &tune : tunes)
+            {
+                bench_t result{};
+                if (!benchSong(engine, *tune, cell.emu, cfg, cell.channels, result))
+                {
+                    error = result.error.empty() ? "interrupted" : result.error;
+                    break;
+                }
+                audio += result.audio;
+                wall  += result.wall;
+            }
+
+            // The first run only warms up caches and clocks
+            if (run && error.empty())
+                runs.push_back(wall > 0. ? audio / wall : 0.);
+        }
+
+        if (m_state != playerRunning)
+            break;
+
+        const std::string name = cellName(cell);
+        double med = 0., p10 = 0., p90 = 0.;
+        if (error.empty())
+        {
+            std::sort(runs.begin(), runs.end());
+            med = median(runs);
+            p10 = percentile(runs, 10);
+            p90 = percentile(runs, 90);
+        }
+        else
+            failed++;
+
+        const auto base = baseline.find(name);
+        const bool compare = error.empty() && (base != baseline.end()) && (base->second > 0.);
+        const double change = compare ? (med / base->second - 1.) * 100. : 0.;
+        const bool regression = compare && (change < -m_bench.threshold);
+        if (regression)
+            failed++;
+
+        if (m_bench.json)
+        {
+            cout << (first ? "[\n  " : ",\n  ")
+                 << "{\"cell\": " << jsonString(name)
+                 << ", \"engine\": \"" << cell.engine
+                 << "\", \"sampling\": \"" << ((cell.sampling == SidConfig::INTERPOLATE) ? "interpolate" : "resample")
+                 << "\", \"fastSampling\": " << (cell.fast ? "true" : "false")
+                 << ", \"frequency\": " << cell.frequency
+                 << ", \"channels\": " << cell.channels
+                 << ", \"chips\": " << cell.chips
+                 << ", \"tunes\": " << tunes.size()
+                 << ", \"seconds\": " << m_bench.seconds
+                 << ", \"runs\": " << runs.size()
+                 << std::setprecision(3) << std::fixed
+                 << ", \"median\": " << med
+                 << ", \"p10\": " << p10
+                 << ", \"p90\": " << p90;
+            if (compare)
+            {
+                cout << ", \"baseline\": " << base->second
+                     << std::setprecision(1)
+                     << ", \"change\": " << change
+                     << ", \"regression\": " << (regression ? "true" : "false");
+            }
+            if (!error.empty())
+                cout << ", \"error\": " << jsonString(error);
+            cout << "}";
+        }
+        else
+        {
+            cout << std::left << std::setw(44) << name << std::right;
+            if (!error.empty())
+                cout << "  ERROR: " << error << endl;
+            else
+            {
+                cout << std::setprecision(1) << std::fixed
+                     << std::setw(10) << med << std::setw(9) << p10 << std::setw(9) << p90;
+                if (compare)
+                    cout << "  baseline " << base->second << std::showpos << " (" << change << "%)" << std::noshowpos
+                         << (regression ? " REGRESSION" : "");
+                cout << endl;
+            }
+        }
+        first = false;
+    }
+
+    if (m_bench.json && !first)
+        cout << "\n]" << endl;
+
+    return failed == 0;
+}
+
+bool ConsolePlayer::bench()
+{
+    sidplayfp engine;
+    engine.setRoms(m_kernalRom.get(), m_basicRom.get(), m_chargenRom.get());
+
+    m_state = playerRunning;
+
+    std::vector<std::string> files;
+    for (const std::string &fileName : m_batch.files)
+        expandFiles(fileName, files);
+
+    unsigned int failed = 0;
+    bool first = true;
+    std::vector<std::unique_ptr<SidTune>> tunes;
+    for (const std::string &fileName : files)
+    {
+        if (m_state != playerRunning)
+            break;
+
+        std::unique_ptr<SidTune> tune(new SidTune(nullptr));
+        tune->load(fileName.c_str());
+        if (!tune->getStatus())
+        {
+            const std::string errorString(tune->statusString());
+
+            // Try prepending HVSC_BASE
+            const char* hvscBase = getenv("HVSC_BASE");
+            if (hvscBase)
+            {
+                std::string newFileName(hvscBase);
+                newFileName.append(SEPARATOR).append(fileName);
+                tune->load(newFileName.c_str());
+            }
+
+            if (!tune->getStatus())
+            {
+                cerr << m_name << ": " << fileName << ": " << errorString << endl;
+                failed++;
+                continue;
+            }
+        }
+
+        const unsigned int song = tune->selectSong(m_track.first);
+
+        // The matrix goes through all the tunes for every cell
+        if (m_bench.matrix)
+        {
+            tunes.push_back(std::move(tune));
+            continue;
+        }
+
+        bench_t result{};
+        result.file = fileName;
+        result.song = song;
+        if (!benchSong(engine, *tune, m_driver.sid, m_engCfg, m_channels, result))
+            failed++;
+        benchReport(result, first);
+        first = false;
+    }
+
+    if (m_bench.json && !first)
+        cout << "\n]" << endl;
+
+    if (m_bench.matrix && (m_state == playerRunning))
+    {
+        if (tunes.empty())
+        {
+            displayError ("ERROR: No tunes to benchmark");
+            return false;
+        }
+
+        if (!benchMatrix(engine, tunes))
+            failed++;
+    }
+
+    // Interrupted by the user
+    if (m_state != playerRunning)
+    {
+        displayError ("Benchmark aborted");
+        return false;
+    }
+
+    m_state = playerExit;
+    return failed == 0;
+}
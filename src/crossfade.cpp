@@ -0,0 +1,266 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "player.h"
+
+#include <algorithm>
+#include <new>
+
+#include <sidplayfp/sidbuilder.h>
+
+/*
+ * Crossfade between consecutive tunes.
+ *
+ * While a tune plays, a second engine on its own thread loads the
+ * tune that follows and renders its start, as long as the fade.
+ * The playing engine runs to the end of its tune as usual and the
+ * prepared start of the next one is faded in over its last part.
+ * The worker's engine is kept where the prepared part ends and the
+ * player carries on with it for the next tune, so nothing is
+ * emulated twice and the transition costs no pre-roll.
+ */
+
+void ConsolePlayer::fadeStart()
+{
+    const uint_least32_t frequency = m_driver.cfg.frequency;
+    const int channels = m_driver.cfg.channels;
+
+    // The start of the tune may have been played by the last fade
+    const uint_least64_t total = (uint_least64_t)(m_timer.stop - m_timer.start) * frequency / 1000 * channels;
+    m_fade.window = (uint_least64_t)m_fade.length * frequency / 1000 * channels;
+    if (total < m_fade.skip + m_fade.window)
+        return;
+
+    m_fade.stopAt   = total - m_fade.skip;
+    m_fade.played   = 0;
+    m_fade.ready    = false;
+    m_fade.cancel   = false;
+    m_fade.mixing   = false;
+    m_fade.position = 0;
+    m_fade.channels = channels;
+    std::copy(vMute, vMute + 9, m_fade.mute);
+
+    // Same choice as made at the end of the tune
+    std::string file;
+    uint_least16_t song;
+    if (!m_track.single && ((m_track.selected % m_track.songs) + 1 != m_track.first))
+    {
+        m_fade.entry = -1;
+        file = m_filename;
+        song = (m_track.selected % m_track.songs) + 1;
+    }
+    else
+    {
+        m_fade.entry = (m_playlist.position + 1) % m_playlist.entries.size();
+        const m_playlist_t::entry_t &entry = m_playlist.entries[m_fade.entry];
+        song = entry.song ? entry.song : m_playlist.first;
+    }
+
+    m_fade.worker = std::thread(&ConsolePlayer::fadeRender, this, m_engCfg, file,
+                                m_fade.entry, song, m_timer.start, m_fade.window);
+}
+
+void ConsolePlayer::fadeRender(SidConfig cfg, std::string file, int entry, uint_least16_t song,
+                               uint_least32_t start, uint_least64_t length)
+{
+    // The pre-roll is long and would starve playback at the same priority
+    realtime::demote();
+
+    std::unique_ptr<SidTune> tune;
+    if (entry < 0)
+    {
+        tune.reset(new SidTune(file.c_str()));
+    }
+    else
+    {   // Resolved as the playlist does
+        m_playlist_t::tune_t loaded;
+        playlistLoad(entry, loaded);
+        tune.swap(loaded.tune);
+    }
+    if (!tune || !tune->getStatus())
+        return;
+
+    m_fade.song = tune->selectSong(song);
+
+    // A tune needing another output format doesn't follow seamlessly
+    const SidTuneInfo *tuneInfo = tune->getInfo();
+    if ((m_channels ? m_channels : ((tuneInfo->sidChips() > 1) ? 2 : 1)) != m_fade.channels)
+        return;
+
+    std::unique_ptr<sidplayfp> engine(new sidplayfp);
+    engine->setRoms(m_kernalRom.get(), m_basicRom.get(), m_chargenRom.get());
+    if (!engine->load(tune.get()))
+        return;
+
+    if (!newSidEmu(m_driver.sid, tuneInfo, cfg.sidEmulation))
+        return;
+    std::unique_ptr<sidbuilder> builder(cfg.sidEmulation);
+
+    if (engine->config(cfg))
+    {
+        for (int i = 0; i < 9; i++)
+            engine->mute(i / 3, i % 3, m_fade.mute[i]);
+
+        engine->fastForward(100 * m_speed.max);
+        if (!start || preRoll(*engine, start, &m_fade.cancel))
+        {
+            engine->fastForward(100);
+            try
+            {
+                std::vector<short> &head = m_fade.head;
+                head.resize(length);
+
+                const uint_least32_t chunk = cfg.frequency / 10 * m_fade.channels;
+                uint_least64_t pos = 0;
+                while ((pos < length) && !m_fade.cancel)
+                {
+                    const uint_least32_t size = std::min<uint_least64_t>(chunk, length - pos);
+                    if (engine->play(&head[pos], size) < size)
+                        break;
+                    pos += size;
+                }
+
+                if (pos == length)
+                {   // The player takes over from here
+                    m_fade.engine.swap(engine);
+                    m_fade.builder = builder.release();
+                    m_fade.tune.swap(tune);
+                    m_fade.ready = true;
+                    return;
+                }
+            }
+            catch (std::bad_alloc const &ba) {}
+        }
+    }
+
+    // Release the emulation before the builder goes away
+    engine->stop();
+    cfg.sidEmulation = nullptr;
+    engine->config(cfg);
+}
+
+// Back to a plain track change, the tune plays to its end
+void ConsolePlayer::fadeCancel()
+{
+    if (m_fade.stopAt)
+    {
+        m_fade.stopAt = 0;
+        fadeStop(false);
+    }
+}
+
+// Wait for the worker, the next tune carries on from the
+// fade only if its start was mixed in completely
+void ConsolePlayer::fadeStop(bool keep)
+{
+    keep = keep && m_fade.mixing && (m_fade.position == m_fade.head.size());
+
+    if (m_fade.worker.joinable())
+    {
+        if (!keep)
+            m_fade.cancel = true;
+        m_fade.worker.join();
+    }
+
+    if (!keep)
+        fadeRelease();
+
+    m_fade.skip     = keep ? m_fade.head.size() : 0;
+    m_fade.head.clear();
+    m_fade.ready    = false;
+    m_fade.mixing   = false;
+    m_fade.position = 0;
+}
+
+// Whether the tune being opened is the one the fade went into,
+// the worker already checked that it needs the same output
+bool ConsolePlayer::fadeFollows()
+{
+    return m_fade.skip
+        && ((m_fade.entry < 0) || (m_fade.entry == (int)m_playlist.position))
+        && (m_fade.song == m_track.selected);
+}
+
+// Carry on with the worker's engine, its emulation and its copy
+// of the tune, already past the part heard during the fade
+void ConsolePlayer::fadeAdopt()
+{
+    // Release the emulation before the builder goes away
+    m_engine->stop();
+    sidbuilder *builder   = m_engCfg.sidEmulation;
+    m_engCfg.sidEmulation = nullptr;
+    m_engine->config(m_engCfg);
+    delete builder;
+
+    m_engine.swap(m_fade.engine);
+    m_fade.engine.reset();
+    m_engCfg.sidEmulation = m_fade.builder;
+    m_fade.builder = nullptr;
+    m_driver.built = m_driver.sid;
+    m_tune.swap(m_fade.tune);
+    m_fade.tune.reset();
+}
+
+// Drop what the worker left, if the next tune doesn't follow
+void ConsolePlayer::fadeRelease()
+{
+    if (m_fade.engine)
+    {
+        m_fade.engine->stop();
+        SidConfig cfg = m_fade.engine->config();
+        cfg.sidEmulation = nullptr;
+        m_fade.engine->config(cfg);
+        m_fade.engine.reset();
+    }
+    delete m_fade.builder;
+    m_fade.builder = nullptr;
+    m_fade.tune.reset();
+}
+
+// Linear crossfade from the end of the playing tune into the next
+void ConsolePlayer::fadeMix(short *buffer, uint_least32_t size)
+{
+    const uint_least64_t from = m_fade.stopAt - m_fade.window;
+    if (m_fade.played + size <= from)
+        return;
+
+    // Don't wait for a late worker, just skip the fade
+    if (m_fade.played <= from)
+        m_fade.mixing = m_fade.ready;
+    if (!m_fade.mixing)
+        return;
+
+    const uint_least32_t offset = (m_fade.played < from) ? (uint_least32_t)(from - m_fade.played) : 0;
+    const size_t total = m_fade.head.size();
+    const short *head  = m_fade.head.data() + m_fade.position;
+    const uint_least32_t count = std::min<size_t>(size - offset, total - m_fade.position);
+    const float step   = 1.f / total;
+    const float start  = m_fade.position * step;
+    short *out = buffer + offset;
+
+    // Only runs over the fade window, once per track change
+    for (uint_least32_t i = 0; i < count; i++)
+    {
+        const float gain = start + i * step;
+        out[i] = (short)(out[i] + (head[i] - out[i]) * gain);
+    }
+
+    m_fade.position += count;
+}
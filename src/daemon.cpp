@@ -0,0 +1,449 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "player.h"
+
+#ifdef HAVE_DAEMON
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using std::cerr;
+using std::endl;
+
+/*
+ * Daemon mode.
+ *
+ * The player stays resident with the configuration, ROMs, songlength
+ * database, sound card and sid emulation ready, and takes commands
+ * from a Unix domain socket. Starting a tune only has to load it and
+ * reset the engine.
+ *
+ * The protocol is line based, each command is answered with
+ * "OK" or "ERR <message>", status lines come before the "OK":
+ *
+ *   play <file>     load a tune and play its default song
+ *   song <n>        play another song of the tune
+ *   next, prev      move to the next or previous song
+ *   seek <time>     restart the song at [mins:]secs[.milli]
+ *   pause           pause or resume
+ *   stop            stop playing, the sound card stays open
+ *   mute <n>        toggle voice n (1-9)
+ *   status          state, file, song, time and length in ms
+ *   stats           audio pipeline timings and device error counts
+ *   quit            shut down the daemon
+ */
+
+// Longest command accepted from a client
+#define MAX_LINE 4096
+
+bool ConsolePlayer::daemonListen()
+{
+    if (m_daemon.socket.empty())
+    {
+        const char *runtime = getenv("XDG_RUNTIME_DIR");
+        if (runtime)
+            m_daemon.socket.assign(runtime).append("/sidplayfp.sock");
+        else
+            m_daemon.socket.assign("/tmp/sidplayfp-").append(std::to_string(getuid())).append(".sock");
+    }
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (m_daemon.socket.length() >= sizeof(addr.sun_path))
+    {
+        displayError("ERROR: Socket path too long");
+        return false;
+    }
+    strcpy(addr.sun_path, m_daemon.socket.c_str());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        displayError(strerror(errno));
+        return false;
+    }
+
+    // Take over a stale socket, but not one that is still served
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0)
+    {
+        ::close(fd);
+        displayError("ERROR: Another daemon is already running");
+        return false;
+    }
+    unlink(m_daemon.socket.c_str());
+
+    // Private from the start, other users must not get in
+    // before the permissions are set
+    const mode_t mask = umask(S_IRWXG | S_IRWXO);
+    const int bound = bind(fd, (sockaddr*)&addr, sizeof(addr));
+    umask(mask);
+
+    if ((bound < 0)
+        || (chmod(m_daemon.socket.c_str(), S_IRUSR | S_IWUSR) < 0)
+        || (listen(fd, 4) < 0))
+    {
+        displayError(strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    m_daemon.listener = fd;
+
+    if (m_verboseLevel)
+        cerr << "Listening on " << m_daemon.socket << endl;
+    return true;
+}
+
+bool ConsolePlayer::daemon()
+{
+    // Replies to clients that went away must not kill the daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    if (!daemonListen())
+        return false;
+
+    // Get the slow parts out of the way before the first tune
+    m_driver.selected = &m_driver.null;
+    if (!createOutput(m_driver.output, nullptr))
+        return false;
+    if (!m_autofilter && !createSidEmu(m_driver.sid, nullptr))
+        return false;
+
+    m_state = playerStopped;
+    m_daemon.running = true;
+    while (m_daemon.running)
+    {
+        // Block when idle, only peek between blocks while playing
+        daemonPoll((m_state == playerRunning) ? 0 : -1);
+
+        if ((m_state == playerRunning) || (m_state == playerPaused))
+        {
+            if (play())
+                continue;
+
+            if ((m_state & ~playerFast) == playerRestart)
+            {   // The tune moved on to its next song
+                m_timer.start = 0;
+                if (open())
+                    continue;
+            }
+            daemonStop();
+        }
+    }
+
+    for (const auto &client : m_daemon.clients)
+        ::close(client.first);
+    m_daemon.clients.clear();
+    ::close(m_daemon.listener);
+    m_daemon.listener = -1;
+    unlink(m_daemon.socket.c_str());
+
+    m_state = playerStopped;
+    return true;
+}
+
+// Accept clients and run the commands they sent
+void ConsolePlayer::daemonPoll(int timeout)
+{
+    std::vector<pollfd> fds(m_daemon.clients.size() + 1);
+    fds[0].fd = m_daemon.listener;
+    fds[0].events = POLLIN;
+    for (size_t i = 0; i < m_daemon.clients.size(); i++)
+    {
+        fds[i + 1].fd = m_daemon.clients[i].first;
+        fds[i + 1].events = POLLIN;
+    }
+
+    if (poll(fds.data(), fds.size(), timeout) <= 0)
+        return;
+
+    // Clients can be dropped and added while handling
+    // commands, walk them by descriptor
+    for (size_t i = 1; i < fds.size(); i++)
+    {
+        if (!fds[i].revents)
+            continue;
+
+        const int fd = fds[i].fd;
+        auto client = m_daemon.clients.begin();
+        while ((client != m_daemon.clients.end()) && (client->first != fd))
+            ++client;
+        if (client == m_daemon.clients.end())
+            continue;
+
+        char buffer[512];
+        const ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+        if ((size < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+            continue;
+        if ((size <= 0) || (client->second.length() + size > MAX_LINE))
+        {
+            ::close(fd);
+            m_daemon.clients.erase(client);
+            continue;
+        }
+
+        std::string &input = client->second;
+        input.append(buffer, size);
+
+        size_t end;
+        while ((end = input.find('\n')) != std::string::npos)
+        {
+            std::string line(input, 0, end);
+            input.erase(0, end + 1);
+            if (!line.empty() && (line.back() == '\r'))
+                line.pop_back();
+            if (!line.empty())
+                daemonCommand(fd, line);
+            if (!m_daemon.running)
+                return;
+        }
+    }
+
+    if (fds[0].revents)
+    {
+        const int fd = accept(m_daemon.listener, nullptr, nullptr);
+        if (fd >= 0)
+        {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            // Replies are sent from the playback loop, never wait for a client
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+            m_daemon.clients.emplace_back(fd, std::string());
+        }
+    }
+}
+
+void ConsolePlayer::daemonReply(int fd, const std::string &reply) const
+{
+    const std::string line = reply + '\n';
+    const ssize_t sent = send(fd, line.data(), line.length(), 0);
+    if (sent == (ssize_t)line.length())
+        return;
+
+    // A client not reading its replies would stall playback,
+    // hang up on it and let the next poll drop it
+    if (m_verboseLevel)
+        cerr << "Reply failed: " << ((sent < 0) ? strerror(errno) : "client not reading") << endl;
+    shutdown(fd, SHUT_RDWR);
+}
+
+void ConsolePlayer::daemonCommand(int fd, const std::string &line)
+{
+    const size_t sep = line.find(' ');
+    const std::string command(line, 0, sep);
+    const std::string arg = (sep != std::string::npos) ? line.substr(sep + 1) : std::string();
+
+    if (m_verboseLevel > 1)
+        cerr << "Command: " << line << endl;
+
+    const bool loaded = !m_filename.empty();
+    const char *error = nullptr;
+    std::string loadError;
+
+    if (command == "play")
+    {
+        if (arg.empty())
+            error = "missing file name";
+        else if (!daemonLoad(arg, loadError))
+            error = loadError.c_str();
+        else if (!daemonStart())
+            error = "cannot play tune";
+    }
+    else if (command == "song")
+    {
+        const int song = atoi(arg.c_str());
+        if (!loaded)
+            error = "no tune loaded";
+        else if ((song < 1) || (song > m_track.songs))
+            error = "invalid song";
+        else
+        {
+            m_track.selected = song;
+            m_timer.start = 0;
+            if (!daemonStart())
+                error = "cannot play song";
+        }
+    }
+    else if ((command == "next") || (command == "prev"))
+    {
+        if (!loaded)
+            error = "no tune loaded";
+        else
+        {
+            if (command == "next")
+                m_track.selected = (m_track.selected % m_track.songs) + 1;
+            else
+                m_track.selected = (m_track.selected > 1) ? m_track.selected - 1 : m_track.songs;
+            m_timer.start = 0;
+            if (!daemonStart())
+                error = "cannot play song";
+        }
+    }
+    else if (command == "seek")
+    {
+        uint_least32_t time;
+        if (!loaded)
+            error = "no tune loaded";
+        else if (!parseTime(arg.c_str(), time))
+            error = "invalid time";
+        else
+        {
+            m_timer.start = time;
+            if (!daemonStart())
+                error = "cannot seek";
+        }
+    }
+    else if (command == "pause")
+    {
+        if (m_state == playerRunning)
+        {
+            m_state = playerPaused;
+            m_driver.selected->pause();
+        }
+        else if (m_state == playerPaused)
+            m_state = playerRunning;
+        else
+            error = "not playing";
+    }
+    else if (command == "stop")
+    {
+        daemonStop();
+    }
+    else if (command == "mute")
+    {
+        const int voice = atoi(arg.c_str()) - 1;
+        if ((voice < 0) || (voice > 8))
+            error = "invalid voice";
+        else
+        {
+            vMute[voice] = !vMute[voice];
+            m_engine->mute(voice / 3, voice % 3, vMute[voice]);
+        }
+    }
+    else if (command == "status")
+    {
+#ifdef FEAT_NEW_SONLEGTH_DB
+        const uint_least32_t milliseconds = m_engine->timeMs();
+#else
+        const uint_least32_t milliseconds = m_engine->time() * 1000;
+#endif
+        const bool active = (m_state == playerRunning) || (m_state == playerPaused);
+
+        std::ostringstream status;
+        status << "state: " << ((m_state == playerRunning) ? "playing"
+            : (m_state == playerPaused) ? "paused" : "stopped") << '\n';
+        if (loaded)
+        {
+            status << "file: " << m_filename << '\n'
+                   << "song: " << m_track.selected << '/' << m_track.songs << '\n'
+                   << "time: " << (active ? milliseconds : 0) << '\n'
+                   << "length: " << m_timer.length << '\n';
+        }
+        status << "mute: ";
+        for (int i = 0; i < 9; i++)
+            status << (vMute[i] ? '1' : '0');
+        daemonReply(fd, status.str());
+    }
+    else if (command == "stats")
+    {
+        std::ostringstream stats;
+        pipelineStats(stats);
+        daemonReply(fd, stats.str());
+    }
+    else if (command == "quit")
+    {
+        daemonStop();
+        m_daemon.running = false;
+    }
+    else
+        error = "unknown command";
+
+    daemonReply(fd, error ? std::string("ERR ").append(error) : "OK");
+}
+
+bool ConsolePlayer::daemonLoad(const std::string &fileName, std::string &error)
+{
+    // Whatever the fade prepared won't follow
+    fadeCancel();
+
+    m_filename = fileName;
+    m_tune->load(m_filename.c_str());
+    if (!m_tune->getStatus())
+    {
+        error.assign(m_tune->statusString());
+
+        // Try prepending HVSC_BASE
+        const char* hvscBase = getenv("HVSC_BASE");
+        if (!hvscBase || !tryOpenTune(hvscBase))
+        {
+            // The engine can't go on with a broken tune
+            daemonStop();
+            m_filename.clear();
+            return false;
+        }
+    }
+
+    m_track.first    = m_tune->selectSong(0);
+    m_track.selected = m_track.first;
+    if (!m_timer.valid)
+        m_timer.length = (m_iniCfg.sidplay2()).playLength;
+    m_timer.start = 0;
+    return true;
+}
+
+// Start the selected song at once
+bool ConsolePlayer::daemonStart()
+{
+    m_state = playerFastRestart;
+    if (!open())
+    {
+        daemonStop();
+        return false;
+    }
+    return true;
+}
+
+// Silence the device but keep it open for the next tune
+void ConsolePlayer::daemonStop()
+{
+    fadeCancel();
+    if ((m_state == playerRunning) || (m_state == playerPaused))
+    {
+        m_engine->stop();
+        m_driver.selected->reset();
+    }
+    m_state = playerStopped;
+}
+
+#endif // HAVE_DAEMON
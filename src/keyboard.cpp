@@ -49,6 +49,8 @@ enum
     PCK_RIGHT         = '\115',
     PCK_END           = '\117',
     PCK_DOWN          = '\120',
+    PCK_PAGE_UP       = '\111',
+    PCK_PAGE_DOWN     = '\121',
     PCK_EXTENDED      = '\340'
 };
 
@@ -62,6 +64,8 @@ static char keytable[] =
     PCK_EXTENDED, PCK_DOWN,0,     A_DOWN_ARROW,
     PCK_EXTENDED, PCK_HOME,0,     A_HOME,
     PCK_EXTENDED, PCK_END,0,      A_END,
+    PCK_EXTENDED, PCK_PAGE_UP,0,  A_PAGE_UP,
+    PCK_EXTENDED, PCK_PAGE_DOWN,0, A_PAGE_DOWN,
 #else
     // Linux Special Keys
     ESC,'[','C',0,          A_RIGHT_ARROW,
@@ -75,6 +79,9 @@ static char keytable[] =
     ESC,'[','H',0,          A_HOME,
     ESC,'[','F',0,          A_END,
 
+    ESC,'[','5','~',0,      A_PAGE_UP,
+    ESC,'[','6','~',0,      A_PAGE_DOWN,
+
     ESC,'[','1','0',0,      A_INVALID,
     ESC,'[','2','0',0,      A_INVALID,
 #endif
@@ -93,6 +100,7 @@ static char keytable[] =
 
     // General Keys
     'p',0,                  A_PAUSED,
+    's',0,                  A_STATS,
     ESC,ESC,0,              A_QUIT,
 
     // Old Keys
@@ -42,6 +42,8 @@ enum
     A_DOWN_ARROW,
     A_HOME,
     A_END,
+    A_PAGE_UP,
+    A_PAGE_DOWN,
     A_PAUSED,
     A_QUIT,
 
@@ -55,7 +57,9 @@ enum
     A_TOGGLE_VOICE7,
     A_TOGGLE_VOICE8,
     A_TOGGLE_VOICE9,
-    A_TOGGLE_FILTER
+    A_TOGGLE_FILTER,
+
+    A_STATS
 };
 
 int  keyboard_decode      ();
@@ -49,6 +49,53 @@ int main(int argc, char *argv[])
             goto main_exit;
     }
 
+    if (player.batchMode ())
+    {
+        // Stop the workers on interrupt
+        if ((signal (SIGINT,  &sighandler) == SIG_ERR)
+         || (signal (SIGTERM, &sighandler) == SIG_ERR))
+        {
+            displayError(argv[0], ERR_SIGHANDLER);
+            goto main_error;
+        }
+
+        if (!player.batch ())
+            goto main_error;
+        goto main_exit;
+    }
+
+    if (player.benchMode ())
+    {
+        // Stop on interrupt
+        if ((signal (SIGINT,  &sighandler) == SIG_ERR)
+         || (signal (SIGTERM, &sighandler) == SIG_ERR))
+        {
+            displayError(argv[0], ERR_SIGHANDLER);
+            goto main_error;
+        }
+
+        if (!player.bench ())
+            goto main_error;
+        goto main_exit;
+    }
+
+#ifdef HAVE_DAEMON
+    if (player.daemonMode ())
+    {
+        // Shut down cleanly on interrupt
+        if ((signal (SIGINT,  &sighandler) == SIG_ERR)
+         || (signal (SIGTERM, &sighandler) == SIG_ERR))
+        {
+            displayError(argv[0], ERR_SIGHANDLER);
+            goto main_error;
+        }
+
+        if (!player.daemon ())
+            goto main_error;
+        goto main_exit;
+    }
+#endif
+
 main_restart:
     if (!player.open ())
         goto main_error;
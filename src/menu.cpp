@@ -142,8 +142,8 @@ void ConsolePlayer::menu ()
     if (m_quietLevel > 1)
         return;
 
-    const SidInfo &info         = m_engine.info ();
-    const SidTuneInfo *tuneInfo = m_tune.getInfo();
+    const SidInfo &info         = m_engine->info ();
+    const SidTuneInfo *tuneInfo = m_tune->getInfo();
 
     // cerr << (char) 12 << '\f'; // New Page
     if ((m_iniCfg.console ()).ansi)
@@ -235,7 +235,7 @@ void ConsolePlayer::menu ()
         consoleColour (green, true);
         cerr << " Condition    : ";
         consoleColour (white, true);
-        cerr << m_tune.statusString() << endl;
+        cerr << m_tune->statusString() << endl;
 
 #if HAVE_TSID == 1
         if (!m_tsid)
@@ -255,6 +255,8 @@ void ConsolePlayer::menu ()
     consoleColour (white, true);
 
     {   // This will be the format used for playlists
+        if (m_playlist.enabled)
+            cerr << (m_playlist.position + 1) << '/' << m_playlist.entries.size() << ", song ";
         int i = 1;
         if (!m_track.single)
         {
@@ -309,6 +311,29 @@ void ConsolePlayer::menu ()
     }
     cerr << endl;
 
+    // Asked for explicitly, so always say what was granted
+    if (m_realtime.applied)
+    {
+        consoleTable  (tableMiddle);
+        consoleColour (green, true);
+        cerr << " Realtime     : ";
+        consoleColour (white, true);
+        cerr << "emulation " << m_realtime.emulation << endl;
+        if (m_driver.ring && m_driver.live)
+        {
+            consoleTable  (tableMiddle);
+            consoleColour (green, true);
+            cerr << "              : ";
+            consoleColour (white, true);
+            cerr << "audio " << m_driver.ring->realtimeStatus() << endl;
+        }
+        consoleTable  (tableMiddle);
+        consoleColour (green, true);
+        cerr << "              : ";
+        consoleColour (white, true);
+        cerr << m_realtime.memory << endl;
+    }
+
     if (m_verboseLevel)
     {
         consoleTable  (tableSeparator);
@@ -431,6 +456,17 @@ void ConsolePlayer::menu ()
             cerr << " Delay        : ";
             consoleColour (white, false);
             cerr << info.powerOnDelay() << " (cycles at poweron)" << endl;
+
+            // What the sound card driver actually gave
+            if (m_driver.live && m_driver.cfg.latency)
+            {
+                consoleTable  (tableMiddle);
+                consoleColour (yellow, true);
+                cerr << " Latency      : ";
+                consoleColour (white, false);
+                cerr << m_driver.cfg.latency << " ms in "
+                     << m_driver.cfg.periods << " periods" << endl;
+            }
         }
     }
 
@@ -516,10 +552,13 @@ void ConsolePlayer::menu ()
 
 void ConsolePlayer::refreshRegDump()
 {
+    if (m_quietLevel > 1)
+        return;
+
 #ifdef FEAT_REGS_DUMP_SID
     if (m_verboseLevel > 1)
     {
-        const SidTuneInfo *tuneInfo = m_tune.getInfo();
+        const SidTuneInfo *tuneInfo = m_tune->getInfo();
 
         cerr << "\x1b[" << tuneInfo->sidChips() * 3 + 1 << "A\r"; // Moves cursor X lines up
 
@@ -531,7 +570,7 @@ void ConsolePlayer::refreshRegDump()
             oldCtl[1] = registers[0x0b];
             oldCtl[2] = registers[0x12];
 
-            if (m_engine.getSidStatus(j, registers))
+            if (m_engine->getSidStatus(j, registers))
             {
                 oldCtl[0] ^= registers[0x04];
                 oldCtl[1] ^= registers[0x0b];
@@ -28,6 +28,8 @@
 #include <fstream>
 #include <sstream>
 #include <new>
+#include <chrono>
+#include <algorithm>
 
 using std::cout;
 using std::cerr;
@@ -43,6 +45,7 @@ using std::endl;
 #include "keyboard.h"
 #include "audio/AudioDrv.h"
 #include "audio/au/auFile.h"
+#include "audio/flac/FlacFile.h"
 #include "audio/wav/WavFile.h"
 #include "ini/types.h"
 
@@ -322,8 +325,10 @@ uint8_t* loadRom(const SID_STRING &romPath, const int size, const TCHAR defaultR
 
 ConsolePlayer::ConsolePlayer (const char * const name) :
     m_name(name),
-    m_tune(nullptr),
+    m_engine(new sidplayfp),
+    m_tune(new SidTune(nullptr)),
     m_state(playerStopped),
+    m_cancel(false),
     m_outfile(nullptr),
     m_filename(""),
     m_fcurve(-1.0),
@@ -338,21 +343,46 @@ ConsolePlayer::ConsolePlayer (const char * const name) :
     // Other defaults
     m_filter.enabled = true;
     m_driver.device  = nullptr;
+    m_driver.ring    = nullptr;
+    m_driver.live    = false;
     m_driver.sid     = EMU_RESIDFP;
+    m_driver.built   = EMU_NONE;
     m_timer.start    = 0;
     m_timer.length   = 0; // FOREVER
     m_timer.valid    = false;
     m_timer.starting = false;
+    m_timer.switching = false;
     m_track.first    = 0;
     m_track.selected = 0;
     m_track.loop     = false;
     m_track.single   = false;
     m_speed.current  = 1;
     m_speed.max      = 32;
+    m_batch.jobs     = 0;
+    m_batch.shard    = 1;
+    m_batch.shards   = 1;
+    m_batch.enabled  = false;
+    m_batch.stems    = STEMS_NONE;
+    m_batch.journal  = nullptr;
+    m_playlist.enabled  = false;
+    m_playlist.position = 0;
+    m_playlist.pending  = -1;
+    m_playlist.step     = 1;
+    m_playlist.quit     = false;
+    m_bench.seconds   = 60;
+    m_bench.enabled   = false;
+    m_bench.json      = false;
+    m_bench.matrix    = false;
+    m_bench.repeat    = 5;
+    m_bench.baseline  = nullptr;
+    m_bench.threshold = 5.;
+    m_daemon.enabled = false;
+    m_daemon.running = false;
+    m_daemon.listener = -1;
 
     // Read default configuration
     m_iniCfg.read ();
-    m_engCfg = m_engine.config ();
+    m_engCfg = m_engine->config ();
 
     {   // Load ini settings
         IniConfig::audio_section     audio     = m_iniCfg.audio();
@@ -371,6 +401,11 @@ ConsolePlayer::ConsolePlayer (const char * const name) :
         m_engCfg.fastSampling = emulation.fastSampling;
         m_channels            = audio.channels;
         m_precision           = audio.precision;
+        m_latency             = audio.latency > 0 ? std::min(audio.latency, MAX_LATENCY_MS) : 0;
+        m_periods             = audio.periods > 0 ? std::min(audio.periods, MAX_PERIODS) : 0;
+        m_realtime.policy     = audio.realtimePolicy;
+        m_realtime.priority   = audio.realtimePriority;
+        m_realtime.applied    = false;
         m_filter.enabled      = emulation.filter;
         m_filter.bias         = emulation.bias;
         m_filter.filterCurve6581 = emulation.filterCurve6581;
@@ -418,23 +453,111 @@ ConsolePlayer::ConsolePlayer (const char * const name) :
 
     m_verboseLevel = (m_iniCfg.sidplay2()).verboseLevel;
 
+    m_fade.length   = (m_iniCfg.sidplay2()).crossfadeLength;
+    m_fade.ready    = false;
+    m_fade.cancel   = false;
+    m_fade.channels = 0;
+    m_fade.entry    = -1;
+    m_fade.builder  = nullptr;
+    m_fade.song     = 0;
+    m_fade.mixing   = false;
+    m_fade.position = 0;
+    m_fade.window   = 0;
+    m_fade.stopAt   = 0;
+    m_fade.played   = 0;
+    m_fade.skip     = 0;
+
     createOutput (OUT_NULL, nullptr);
     createSidEmu (EMU_NONE, nullptr);
 
-    uint8_t *kernalRom = loadRom((m_iniCfg.sidplay2()).kernalRom, 8192, TEXT("kernal"));
-    uint8_t *basicRom = loadRom((m_iniCfg.sidplay2()).basicRom, 8192, TEXT("basic"));
-    uint8_t *chargenRom = loadRom((m_iniCfg.sidplay2()).chargenRom, 4096, TEXT("chargen"));
-    m_engine.setRoms(kernalRom, basicRom, chargenRom);
-    delete [] kernalRom;
-    delete [] basicRom;
-    delete [] chargenRom;
+    m_kernalRom.reset(loadRom((m_iniCfg.sidplay2()).kernalRom, 8192, TEXT("kernal")));
+    m_basicRom.reset(loadRom((m_iniCfg.sidplay2()).basicRom, 8192, TEXT("basic")));
+    m_chargenRom.reset(loadRom((m_iniCfg.sidplay2()).chargenRom, 4096, TEXT("chargen")));
+    m_engine->setRoms(m_kernalRom.get(), m_basicRom.get(), m_chargenRom.get());
 }
 
-std::string ConsolePlayer::getFileName(const SidTuneInfo *tuneInfo, const char* ext)
+// Expand the batch output template
+static std::string expandTemplate(const char *format, const SidTuneInfo *tuneInfo, const char* ext)
 {
     std::string title;
+    bool hasSong = false;
+
+    for (const char *p = format; *p != '\0'; p++)
+    {
+        if ((*p != '%') || (p[1] == '\0'))
+        {
+            title.push_back(*p);
+            continue;
+        }
+
+        std::string field;
+        switch (*++p)
+        {
+        case 'p':
+            title.append(tuneInfo->path());
+            continue;
+        case 'f':
+        {
+            field = tuneInfo->dataFileName();
+            const size_t dot = field.find_last_of('.');
+            if (dot != std::string::npos)
+                field.erase(dot);
+        }
+            break;
+        case 'n':
+            field = std::to_string(tuneInfo->currentSong());
+            hasSong = true;
+            break;
+        case 't':
+        case 'a':
+        case 'r':
+        {
+            const unsigned int index = (*p == 't') ? 0 : (*p == 'a') ? 1 : 2;
+            if (tuneInfo->numberOfInfoStrings() > index)
+                field = tuneInfo->infoString(index);
+            break;
+        }
+        default:
+            title.push_back(*p);
+            continue;
+        }
 
-    if (m_outfile != nullptr)
+        // Don't let tune metadata escape the output directory
+        for (char &c : field)
+        {
+            if (strchr("/\\:*?\"<>|", c) != nullptr)
+                c = '_';
+        }
+        title.append(field);
+    }
+
+    // Keep subtunes apart even if not asked to
+    const std::string::size_type dot = title.find_last_of('.');
+    const std::string::size_type sep = title.find_last_of("/\\");
+    const bool hasExt = (dot != std::string::npos) && ((sep == std::string::npos) || (dot > sep));
+
+    if (!hasSong && (tuneInfo->songs() > 1))
+    {
+        std::ostringstream sstream;
+        sstream << "[" << tuneInfo->currentSong() << "]";
+        title.insert(hasExt ? dot : title.length(), sstream.str());
+    }
+
+    if (!hasExt)
+        title.append(ext);
+
+    return title;
+}
+
+std::string ConsolePlayer::getFileName(const SidTuneInfo *tuneInfo, const char* ext) const
+{
+    std::string title;
+
+    if (m_batch.enabled)
+    {
+        title = expandTemplate(m_outfile != nullptr ? m_outfile : "%f", tuneInfo, ext);
+    }
+    else if (m_outfile != nullptr)
     {
         title = m_outfile;
         if (title.compare("-") != 0
@@ -461,17 +584,57 @@ std::string ConsolePlayer::getFileName(const SidTuneInfo *tuneInfo, const char*
     return title;
 }
 
+// Query the songlength database, zero if not found
+int_least32_t ConsolePlayer::songLength(SidTune &tune)
+{
+#ifdef FEAT_NEW_SONLEGTH_DB
+    if (m_lengthIndex.isOpen())
+    {   // Read only, no locking needed
+        char md5[SidTune::MD5_LENGTH + 1];
+        tune.createMD5New(md5);
+        return m_lengthIndex.lengthMs(md5, tune.getInfo()->currentSong());
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(m_batch.lock);
+#ifdef FEAT_NEW_SONLEGTH_DB
+    return songlengthDB == SLDB_MD5 ? m_database.lengthMs(tune) : (m_database.length(tune) * 1000);
+#else
+    return m_database.length(tune) * 1000;
+#endif
+}
+
 // Create the output object to process sound buffer
 bool ConsolePlayer::createOutput (OUTPUTS driver, const SidTuneInfo *tuneInfo)
 {
+    int tuneChannels = (tuneInfo && (tuneInfo->sidChips() > 1)) ? 2 : 1;
+
+    // Reopening the sound card between tracks is slow and
+    // leaves a gap, keep it running if the format is the same
+    if ((driver == OUT_SOUNDCARD) && m_driver.live
+        && (m_driver.cfg.frequency == m_engCfg.frequency)
+        && (m_driver.cfg.channels == (m_channels ? m_channels : tuneChannels))
+        && (m_driver.cfg.precision == m_precision))
+    {
+        // Hold what is queued while the next tune loads, the ring
+        // running dry meanwhile is not an underrun. A fade carried
+        // over continues right away.
+        if (m_driver.ring && !m_fade.skip)
+            m_driver.ring->pause();
+        m_driver.selected = &m_driver.null;
+        return true;
+    }
+
     // Remove old audio driver
     m_driver.null.close ();
     m_driver.selected = &m_driver.null;
+    m_driver.live     = false;
     if (m_driver.device != nullptr)
     {
         if (m_driver.device != &m_driver.null)
             delete m_driver.device;
         m_driver.device = nullptr;
+        m_driver.ring   = nullptr;
     }
 
     // Create audio driver
@@ -482,9 +645,24 @@ bool ConsolePlayer::createOutput (OUTPUTS driver, const SidTuneInfo *tuneInfo)
     break;
 
     case OUT_SOUNDCARD:
+        if ((m_realtime.policy != realtime::OFF) && !m_realtime.applied)
+        {
+            // Once for the whole run, before the first buffer is rendered
+            m_realtime.memory    = realtime::lockMemory();
+            m_realtime.emulation = realtime::promote(m_realtime.policy, m_realtime.priority - 1);
+            m_realtime.applied   = true;
+        }
         try
         {
-            m_driver.device = new audioDrv();
+            const int ringDepth = (m_iniCfg.audio()).ringDepth;
+            if (ringDepth > 0)
+            {
+                m_driver.ring   = new audioRing(new audioDrv(), ringDepth);
+                m_driver.ring->setRealtime(m_realtime.policy, m_realtime.priority);
+                m_driver.device = m_driver.ring;
+            }
+            else
+                m_driver.device = new audioDrv();
         }
         catch (std::bad_alloc const &ba)
         {
@@ -499,6 +677,11 @@ bool ConsolePlayer::createOutput (OUTPUTS driver, const SidTuneInfo *tuneInfo)
             WavFile* wav = new WavFile(title);
             if (m_driver.info && (tuneInfo->numberOfInfoStrings() == 3))
                 wav->setInfo(tuneInfo->infoString(0), tuneInfo->infoString(1), tuneInfo->infoString(2));
+            // Length of the recorded part, if known
+            if (m_timer.valid)
+                wav->setLength(m_timer.length);
+            else if (m_timer.length > m_timer.start)
+                wav->setLength(m_timer.length - m_timer.start);
             m_driver.device = wav;
         }
         catch (std::bad_alloc const &ba)
@@ -519,6 +702,25 @@ bool ConsolePlayer::createOutput (OUTPUTS driver, const SidTuneInfo *tuneInfo)
         }
     break;
 
+#ifdef HAVE_FLAC
+    case OUT_FLAC:
+        try
+        {
+            std::string title = getFileName(tuneInfo, FlacFile::extension());
+            // Leave some cores to the emulation
+            const unsigned int threads = std::min(std::thread::hardware_concurrency(), 4u);
+            FlacFile* flac = new FlacFile(title, threads);
+            if (m_driver.info && (tuneInfo->numberOfInfoStrings() == 3))
+                flac->setInfo(tuneInfo->infoString(0), tuneInfo->infoString(1), tuneInfo->infoString(2));
+            m_driver.device = flac;
+        }
+        catch (std::bad_alloc const &ba)
+        {
+            m_driver.device = nullptr;
+        }
+    break;
+#endif
+
     default:
         break;
     }
@@ -531,13 +733,13 @@ bool ConsolePlayer::createOutput (OUTPUTS driver, const SidTuneInfo *tuneInfo)
         return false;
     }
 
-    int tuneChannels = (tuneInfo && (tuneInfo->sidChips() > 1)) ? 2 : 1;
-
     // Configure with user settings
     m_driver.cfg.frequency = m_engCfg.frequency;
     m_driver.cfg.channels = m_channels ? m_channels : tuneChannels;
     m_driver.cfg.precision = m_precision;
     m_driver.cfg.bufSize   = 0; // Recalculate
+    m_driver.cfg.latency   = m_latency;
+    m_driver.cfg.periods   = m_periods;
 
     {   // Open the hardware
         bool err = false;
@@ -558,6 +760,9 @@ bool ConsolePlayer::createOutput (OUTPUTS driver, const SidTuneInfo *tuneInfo)
         }
     }
 
+    // A new device starts counting afresh
+    m_stats.reset();
+
     // See what we got
     m_engCfg.frequency = m_driver.cfg.frequency;
     switch (m_driver.cfg.channels)
@@ -573,6 +778,8 @@ bool ConsolePlayer::createOutput (OUTPUTS driver, const SidTuneInfo *tuneInfo)
              << " audio channels not supported" << endl;
         return false;
     }
+
+    m_driver.live = driver == OUT_SOUNDCARD;
     return true;
 }
 
@@ -580,15 +787,33 @@ bool ConsolePlayer::createOutput (OUTPUTS driver, const SidTuneInfo *tuneInfo)
 // Create the sid emulation
 bool ConsolePlayer::createSidEmu (SIDEMUS emu, const SidTuneInfo *tuneInfo)
 {
+    // Building the emulation is costly, keep it across tunes
+    // unless its settings depend on the tune
+    if (m_engCfg.sidEmulation && (emu == m_driver.built) && !m_autofilter)
+        return true;
+
     // Remove old driver and emulation
     if (m_engCfg.sidEmulation)
     {
         sidbuilder *builder   = m_engCfg.sidEmulation;
         m_engCfg.sidEmulation = nullptr;
-        m_engine.config(m_engCfg);
+        m_engine->config(m_engCfg);
         delete builder;
     }
 
+    m_driver.built = EMU_NONE;
+    if (!newSidEmu(emu, tuneInfo, m_engCfg.sidEmulation))
+        return false;
+    m_driver.built = emu;
+    return true;
+}
+
+
+// Build a sid emulation, also used by the batch workers
+bool ConsolePlayer::newSidEmu (SIDEMUS emu, const SidTuneInfo *tuneInfo, sidbuilder *&builder) const
+{
+    builder = nullptr;
+
     // Now setup the sid emulation
     switch (emu)
     {
@@ -599,10 +824,10 @@ bool ConsolePlayer::createSidEmu (SIDEMUS emu, const SidTuneInfo *tuneInfo)
         {
             ReSIDfpBuilder *rs = new ReSIDfpBuilder( RESIDFP_ID );
 
-            m_engCfg.sidEmulation = rs;
-            if (!rs->getStatus()) goto createSidEmu_error;
-            rs->create ((m_engine.info ()).maxsids());
-            if (!rs->getStatus()) goto createSidEmu_error;
+            builder = rs;
+            if (!rs->getStatus()) goto newSidEmu_error;
+            rs->create ((m_engine->info ()).maxsids());
+            if (!rs->getStatus()) goto newSidEmu_error;
 
 #ifdef FEAT_CW_STRENGTH
             rs->combinedWaveformsStrength(m_combinedWaveformsStrength);
@@ -683,10 +908,10 @@ bool ConsolePlayer::createSidEmu (SIDEMUS emu, const SidTuneInfo *tuneInfo)
         {
             ReSIDBuilder *rs = new ReSIDBuilder( RESID_ID );
 
-            m_engCfg.sidEmulation = rs;
-            if (!rs->getStatus()) goto createSidEmu_error;
-            rs->create ((m_engine.info ()).maxsids());
-            if (!rs->getStatus()) goto createSidEmu_error;
+            builder = rs;
+            if (!rs->getStatus()) goto newSidEmu_error;
+            rs->create ((m_engine->info ()).maxsids());
+            if (!rs->getStatus()) goto newSidEmu_error;
 
             rs->bias(m_filter.bias);
         }
@@ -702,10 +927,10 @@ bool ConsolePlayer::createSidEmu (SIDEMUS emu, const SidTuneInfo *tuneInfo)
         {
             HardSIDBuilder *hs = new HardSIDBuilder( HARDSID_ID );
 
-            m_engCfg.sidEmulation = hs;
-            if (!hs->getStatus()) goto createSidEmu_error;
-            hs->create ((m_engine.info ()).maxsids());
-            if (!hs->getStatus()) goto createSidEmu_error;
+            builder = hs;
+            if (!hs->getStatus()) goto newSidEmu_error;
+            hs->create ((m_engine->info ()).maxsids());
+            if (!hs->getStatus()) goto newSidEmu_error;
         }
         catch (std::bad_alloc const &ba) {}
         break;
@@ -719,10 +944,10 @@ bool ConsolePlayer::createSidEmu (SIDEMUS emu, const SidTuneInfo *tuneInfo)
         {
             exSIDBuilder *hs = new exSIDBuilder( EXSID_ID );
 
-            m_engCfg.sidEmulation = hs;
-            if (!hs->getStatus()) goto createSidEmu_error;
-            hs->create ((m_engine.info ()).maxsids());
-            if (!hs->getStatus()) goto createSidEmu_error;
+            builder = hs;
+            if (!hs->getStatus()) goto newSidEmu_error;
+            hs->create ((m_engine->info ()).maxsids());
+            if (!hs->getStatus()) goto newSidEmu_error;
         }
         catch (std::bad_alloc const &ba) {}
         break;
@@ -736,7 +961,7 @@ bool ConsolePlayer::createSidEmu (SIDEMUS emu, const SidTuneInfo *tuneInfo)
         break;
     }
 
-    if (!m_engCfg.sidEmulation)
+    if (!builder)
     {
         if (emu > EMU_DEFAULT)
         {   // No sid emulation?
@@ -745,17 +970,17 @@ bool ConsolePlayer::createSidEmu (SIDEMUS emu, const SidTuneInfo *tuneInfo)
         }
     }
 
-    if (m_engCfg.sidEmulation) {
+    if (builder) {
         /* set up SID filter. HardSID just ignores call with def. */
-        m_engCfg.sidEmulation->filter(m_filter.enabled);
+        builder->filter(m_filter.enabled);
     }
 
     return true;
 
-createSidEmu_error:
-    displayError (m_engCfg.sidEmulation->error ());
-    delete m_engCfg.sidEmulation;
-    m_engCfg.sidEmulation = nullptr;
+newSidEmu_error:
+    displayError (builder->error ());
+    delete builder;
+    builder = nullptr;
     return false;
 }
 
@@ -764,35 +989,70 @@ bool ConsolePlayer::open (void)
 {
     if ((m_state & ~playerFast) == playerRestart)
     {
+        m_timer.restart   = std::chrono::steady_clock::now();
+        m_timer.switching = true;
+        // Only fade into tunes that follow naturally
+        fadeStop(m_state == playerRestart);
         if (m_quietLevel < 2)
             cerr << endl;
         if (m_state & playerFast)
             m_driver.selected->reset ();
         m_state = playerStopped;
+
+        // Move on to another playlist entry
+        if ((m_playlist.pending >= 0) && !playlistSwitch())
+            return false;
     }
 
     // Select the required song
-    m_track.selected = m_tune.selectSong(m_track.selected);
-    if (!m_engine.load (&m_tune))
+    m_track.selected = m_tune->selectSong(m_track.selected);
+
+    // Did the fade go into this tune? Then the engine that rendered
+    // it carries on, with the tune loaded and the start already played
+    const bool follows = fadeFollows();
+    if (follows)
     {
-        displayError (m_engine.error());
-        return false;
+        fadeAdopt();
+    }
+    else
+    {
+        fadeRelease();
+        m_fade.skip = 0;
+        if (!m_engine->load (m_tune.get()))
+        {
+            displayError (m_engine->error());
+            return false;
+        }
     }
 
     // Get tune details
-    const SidTuneInfo *tuneInfo = m_tune.getInfo();
+    const SidTuneInfo *tuneInfo = m_tune->getInfo();
     if (!m_track.single)
         m_track.songs = tuneInfo->songs();
+
+    // As yet we don't have a required songlength
+    // so try the songlength database or keep the default
+    if (!m_timer.valid)
+    {   // Playlist entries come with their lengths
+        const int_least32_t length = (m_track.selected <= m_playlist.lengths.size())
+            ? m_playlist.lengths[m_track.selected - 1] : songLength(*m_tune);
+        if (length > 0)
+            m_timer.length = length;
+    }
+
     if (!createOutput(m_driver.output, tuneInfo))
         return false;
-    if (!createSidEmu(m_driver.sid, tuneInfo))
-        return false;
+    if (!follows)
+    {
+        if (!createSidEmu(m_driver.sid, tuneInfo))
+            return false;
 
-    // Configure engine with settings
-    if (!m_engine.config(m_engCfg))
-    {   // Config failed
-        displayError(m_engine.error ());
-        return false;
+        // Configure engine with settings
+        if (!m_engine->config(m_engCfg))
+        {   // Config failed
+            displayError(m_engine->error ());
+            return false;
+        }
     }
 #ifdef FEAT_REGS_DUMP_SID
     m_freqTable = (tuneInfo->clockSpeed() == SidTuneInfo::CLOCK_NTSC) ? freqTableNtsc : freqTablePal;
@@ -801,30 +1061,17 @@ bool ConsolePlayer::open (void)
     // forwarding to the start position
     m_driver.selected = &m_driver.null;
     m_speed.current   = m_speed.max;
-    m_engine.fastForward (100 * m_speed.current);
-
-    m_engine.mute(0, 0, vMute[0]);
-    m_engine.mute(0, 1, vMute[1]);
-    m_engine.mute(0, 2, vMute[2]);
-    m_engine.mute(1, 0, vMute[3]);
-    m_engine.mute(1, 1, vMute[4]);
-    m_engine.mute(1, 2, vMute[5]);
-    m_engine.mute(2, 0, vMute[6]);
-    m_engine.mute(2, 1, vMute[7]);
-    m_engine.mute(2, 2, vMute[8]);
-
-    // As yet we don't have a required songlength
-    // so try the songlength database or keep the default
-    if (!m_timer.valid)
-    {
-#ifdef FEAT_NEW_SONLEGTH_DB
-        const int_least32_t length = songlengthDB == SLDB_MD5 ? m_database.lengthMs(m_tune) : (m_database.length(m_tune) * 1000);
-#else
-        const int_least32_t length = m_database.length(m_tune) * 1000;
-#endif
-        if (length > 0)
-            m_timer.length = length;
-    }
+    m_engine->fastForward (100 * m_speed.current);
+
+    m_engine->mute(0, 0, vMute[0]);
+    m_engine->mute(0, 1, vMute[1]);
+    m_engine->mute(0, 2, vMute[2]);
+    m_engine->mute(1, 0, vMute[3]);
+    m_engine->mute(1, 1, vMute[4]);
+    m_engine->mute(1, 2, vMute[5]);
+    m_engine->mute(2, 0, vMute[6]);
+    m_engine->mute(2, 1, vMute[7]);
+    m_engine->mute(2, 2, vMute[8]);
 
     // Set up the play timer
     m_timer.stop = m_timer.length;
@@ -843,6 +1090,24 @@ bool ConsolePlayer::open (void)
         }
     }
 
+    // Get to the start position without producing audio
+    if (!follows && m_timer.start && !preRoll(*m_engine, m_timer.start))
+    {
+        displayError(m_cancel ? "Seek cancelled" : m_engine->error ());
+        return false;
+    }
+
+    // Fade into the next tune over the end of this one if another follows
+    m_fade.stopAt = 0;
+    if (m_fade.length && !m_driver.file && m_timer.stop
+        && (m_timer.stop > m_timer.start + m_fade.length)
+        && ((!m_track.single && ((m_track.selected % m_track.songs) + 1 != m_track.first))
+            || (m_playlist.enabled && (m_track.loop || (m_playlist.position + 1 < m_playlist.entries.size())))))
+    {
+        fadeStart();
+    }
+    m_fade.skip = 0;
+
     m_timer.current = ~0;
     m_timer.starting = true;
     m_state = playerRunning;
@@ -853,9 +1118,44 @@ bool ConsolePlayer::open (void)
     return true;
 }
 
+// Advance the emulation to the start position. This runs the
+// engine's discard path, which still clocks and resamples the chips
+// but skips mixing them and copying out the samples, and isn't bound
+// by the fast forward limit.
+bool ConsolePlayer::preRoll(sidplayfp &engine, uint_least32_t startMs, const std::atomic<bool> *cancel)
+{
+    const auto begin = std::chrono::steady_clock::now();
+
+    for (;;)
+    {
+#ifdef FEAT_NEW_SONLEGTH_DB
+        const uint_least32_t milliseconds = engine.timeMs();
+#else
+        const uint_least32_t milliseconds = engine.time() * 1000;
+#endif
+        if (milliseconds >= startMs)
+            break;
+
+        engine.play(nullptr, 0);
+        if (!engine.isPlaying() || m_cancel || (cancel && *cancel))
+            return false;
+    }
+
+    if (m_verboseLevel)
+    {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        std::lock_guard<std::mutex> lock(m_batch.lock);
+        cerr << "Pre-roll to " << std::setprecision(3) << std::fixed << (startMs / 1000.)
+             << "s took " << elapsed.count() << "s" << endl;
+    }
+    return true;
+}
+
 void ConsolePlayer::close ()
 {
-    m_engine.stop();
+    playlistStop();
+    fadeStop(false);
+    m_engine->stop();
     if (m_state == playerExit)
     {   // Natural finish
         emuflush ();
@@ -865,11 +1165,31 @@ void ConsolePlayer::close ()
     else // Destroy buffers
         m_driver.selected->reset ();
 
+    if (m_driver.ring != nullptr)
+    {   // Let the queued blocks play out before reporting
+        m_driver.ring->close();
+        if (m_verboseLevel)
+        {
+            audioRing::stats_t stats;
+            m_driver.ring->getStats(stats);
+            cerr << endl << "Audio ring: depth " << stats.depth
+                 << ", fill avg " << std::setprecision(2) << std::fixed << stats.avgFill
+                 << " min " << stats.minFill
+                 << ", underruns " << stats.underruns;
+        }
+    }
+
+    if (m_verboseLevel && (m_driver.device != nullptr))
+    {
+        cerr << endl << "Audio pipeline:" << endl;
+        pipelineStats(cerr);
+    }
+
     // Shutdown drivers, etc
     createOutput    (OUT_NULL, nullptr);
     createSidEmu    (EMU_NONE, nullptr);
-    m_engine.load   (nullptr);
-    m_engine.config (m_engCfg);
+    m_engine->load   (nullptr);
+    m_engine->config (m_engCfg);
 
     if (m_quietLevel < 2)
     {   // Correctly leave ansi mode and get prompt to
@@ -911,29 +1231,55 @@ bool ConsolePlayer::play()
     {
         updateDisplay();
 
-        // Fill buffer
-        short *buffer = m_driver.selected->buffer();
+        // Fill buffer, after a possible switch to the device
         const uint_least32_t length = getBufSize();
-        retSize = m_engine.play(buffer, length);
+        short *buffer = m_driver.selected->buffer();
+
+        // Pre-roll and fast forward aren't timed
+        audioStats *stats = (m_driver.selected == m_driver.device) ? &m_stats : nullptr;
+        const auto rendering = std::chrono::steady_clock::now();
+        {
+            audioStats::timer timer(stats, audioStats::EMULATION);
+            retSize = m_engine->play(buffer, length);
+        }
         if (retSize < length)
         {
-            if (m_engine.isPlaying())
+            if (m_engine->isPlaying())
             {
                 m_state = playerError;
             }
             return false;
         }
+
+        if (stats)
+        {
+            audioStats::timer timer(stats, audioStats::PROCESSING);
+            if (m_fade.stopAt)
+                fadeMix(buffer, retSize);
+            m_fade.played += retSize;
+        }
+
+        // Made slower than it plays, the device will starve
+        if (stats && (m_driver.output == OUT_SOUNDCARD) && (m_speed.current == 1))
+        {
+            const std::chrono::duration<double> taken = std::chrono::steady_clock::now() - rendering;
+            if (taken.count() * m_driver.cfg.frequency * m_driver.cfg.channels > retSize)
+                m_stats.count(audioStats::LATE_BUFFERS);
+        }
     }
 
     switch (m_state)
     {
     case playerRunning:
+    {
+        audioStats::timer timer((m_driver.selected == m_driver.device) ? &m_stats : nullptr, audioStats::OUTPUT);
         if (!m_driver.selected->write(retSize))
         {
             cerr << m_driver.selected->getErrorString();
             m_state = playerError;
             return false;
         }
+    }
         // fall-through
     case playerPaused:
         // Check for a keypress (approx 250ms rate, but really depends
@@ -945,7 +1291,7 @@ bool ConsolePlayer::play()
     default:
         if (m_quietLevel < 2)
             cerr << endl;
-        m_engine.stop ();
+        m_engine->stop ();
 #if HAVE_TSID == 1
         if (m_tsid)
         {
@@ -956,10 +1302,12 @@ bool ConsolePlayer::play()
         {
             char md5[SidTune::MD5_LENGTH + 1];
             if (newSonglengthDB)
-                m_tune.createMD5New(md5);
+                m_tune->createMD5New(md5);
             else
-                m_tune.createMD5(md5);
-            int_least32_t length = m_database.lengthMs(md5, m_track.selected);
+                m_tune->createMD5(md5);
+            int_least32_t length = m_lengthIndex.isOpen()
+                ? m_lengthIndex.lengthMs(md5, m_track.selected)
+                : m_database.lengthMs(md5, m_track.selected);
             // ignore errors
             if (length < 0)
                 length = 0;
@@ -975,11 +1323,23 @@ bool ConsolePlayer::play()
 
 void ConsolePlayer::stop ()
 {
+    m_daemon.running = false;
+    m_cancel = true;
     m_state = playerStopped;
-    m_engine.stop ();
+    m_engine->stop ();
 }
 
 
+// Player and device figures together
+void ConsolePlayer::pipelineStats(std::ostream &out)
+{
+    audioStats stats;
+    stats.add(m_stats);
+    if ((m_driver.device != nullptr) && (m_driver.device->stats() != nullptr))
+        stats.add(*m_driver.device->stats());
+    stats.report(out);
+}
+
 uint_least32_t ConsolePlayer::getBufSize()
 {
     if (m_timer.starting && (m_timer.current >= m_timer.start))
@@ -988,29 +1348,56 @@ uint_least32_t ConsolePlayer::getBufSize()
         m_driver.selected = m_driver.device;
         memset(m_driver.selected->buffer (), 0, m_driver.cfg.bufSize);
         m_speed.current = 1;
-        m_engine.fastForward(100);
+        m_engine->fastForward(100);
         if (m_cpudebug)
-            m_engine.debug (true, nullptr);
+            m_engine->debug (true, nullptr);
+
+        if (m_timer.switching)
+        {   // Time taken to get the next track playing
+            m_timer.switching = false;
+            if (m_verboseLevel)
+            {
+                const std::chrono::duration<double, std::milli> elapsed =
+                    std::chrono::steady_clock::now() - m_timer.restart;
+                cerr << "Track switch: " << std::setprecision(1) << std::fixed
+                     << elapsed.count() << "ms" << endl;
+            }
+        }
     }
-    else if ((m_timer.stop != 0) && (m_timer.current >= m_timer.stop))
+    else if (m_fade.stopAt ? (m_fade.played >= m_fade.stopAt)
+        : ((m_timer.stop != 0) && (m_timer.current >= m_timer.stop)))
     {
         m_state = playerExit;
         for (;;)
         {
-            if (m_track.single)
-                return 0;
-            // Move to next track
-            m_track.selected++;
-            if (m_track.selected > m_track.songs)
-                m_track.selected = 1;
-            if (m_track.selected == m_track.first)
-                return 0;
-            m_state = playerRestart;
-            break;
+            if (!m_track.single)
+            {   // Move to next track
+                m_track.selected++;
+                if (m_track.selected > m_track.songs)
+                    m_track.selected = 1;
+                if (m_track.selected != m_track.first)
+                {
+                    m_state = playerRestart;
+                    break;
+                }
+            }
+            // Then to the next playlist entry
+            if (m_playlist.enabled && playlistSelect(m_playlist.position + 1, 1))
+            {
+                m_state = playerRestart;
+                break;
+            }
+            return 0;
         }
         if (m_track.loop)
             m_state = playerRestart;
     }
+    else if (m_fade.stopAt)
+    {   // Stop on the exact sample the fade takes over from
+        const uint_least64_t remaining = m_fade.stopAt - m_fade.played;
+        if (remaining < m_driver.cfg.bufSize)
+            return remaining;
+    }
     else
     {
         uint_least32_t remaining = m_timer.stop - m_timer.current;
@@ -1027,10 +1414,10 @@ uint_least32_t ConsolePlayer::getBufSize()
 void ConsolePlayer::updateDisplay()
 {
 #ifdef FEAT_NEW_SONLEGTH_DB
-    const uint_least32_t milliseconds = m_engine.timeMs();
+    const uint_least32_t milliseconds = m_engine->timeMs();
     const uint_least32_t seconds = milliseconds / 1000;
 #else
-    const uint_least32_t seconds = m_engine.time();
+    const uint_least32_t seconds = m_engine->time();
     const uint_least32_t milliseconds = seconds * 1000;
 #endif
 
@@ -1047,7 +1434,7 @@ void ConsolePlayer::updateDisplay()
     m_timer.current = milliseconds;
 }
 
-void ConsolePlayer::displayError (const char *error)
+void ConsolePlayer::displayError (const char *error) const
 {
     cerr << m_name << ": " << error << endl;
 }
@@ -1079,9 +1466,9 @@ void ConsolePlayer::decodeKeys ()
             {   // Only select previous song if less than timeout
                 // else restart current song
 #ifdef FEAT_NEW_SONLEGTH_DB
-    const uint_least32_t milliseconds = m_engine.timeMs();
+    const uint_least32_t milliseconds = m_engine->timeMs();
 #else
-    const uint_least32_t milliseconds = m_engine.time() * 1000;
+    const uint_least32_t milliseconds = m_engine->time() * 1000;
 #endif
                 if (milliseconds < SID2_PREV_SONG_TIMEOUT)
                 {
@@ -1093,16 +1480,18 @@ void ConsolePlayer::decodeKeys ()
         break;
 
         case A_UP_ARROW:     
+            // Fast forward loses track of the fade point
+            fadeCancel();
             m_speed.current *= 2;
             if (m_speed.current > m_speed.max)
                 m_speed.current = m_speed.max;
   
-            m_engine.fastForward (100 * m_speed.current);
+            m_engine->fastForward (100 * m_speed.current);
         break;
 
         case A_DOWN_ARROW:
             m_speed.current = 1;
-            m_engine.fastForward (100);
+            m_engine->fastForward (100);
         break;
 
         case A_HOME:
@@ -1115,6 +1504,16 @@ void ConsolePlayer::decodeKeys ()
             m_track.selected = m_track.songs;
         break;
 
+        case A_PAGE_UP:
+            if (m_playlist.enabled && playlistSelect(m_playlist.position - 1, -1))
+                m_state = playerFastRestart;
+        break;
+
+        case A_PAGE_DOWN:
+            if (m_playlist.enabled && playlistSelect(m_playlist.position + 1, 1))
+                m_state = playerFastRestart;
+        break;
+
         case A_PAUSED:
             if (m_state == playerPaused)
             {
@@ -1134,47 +1533,47 @@ void ConsolePlayer::decodeKeys ()
 
         case A_TOGGLE_VOICE1:
             vMute[0] = !vMute[0];
-            m_engine.mute(0, 0, vMute[0]);
+            m_engine->mute(0, 0, vMute[0]);
         break;
 
         case A_TOGGLE_VOICE2:
             vMute[1] = !vMute[1];
-            m_engine.mute(0, 1, vMute[1]);
+            m_engine->mute(0, 1, vMute[1]);
         break;
 
         case A_TOGGLE_VOICE3:
             vMute[2] = !vMute[2];
-            m_engine.mute(0, 2, vMute[2]);
+            m_engine->mute(0, 2, vMute[2]);
         break;
 
         case A_TOGGLE_VOICE4:
             vMute[3] = !vMute[3];
-            m_engine.mute(1, 0, vMute[3]);
+            m_engine->mute(1, 0, vMute[3]);
         break;
 
         case A_TOGGLE_VOICE5:
             vMute[4] = !vMute[4];
-            m_engine.mute(1, 1, vMute[4]);
+            m_engine->mute(1, 1, vMute[4]);
         break;
 
         case A_TOGGLE_VOICE6:
             vMute[5] = !vMute[5];
-            m_engine.mute(1, 2, vMute[5]);
+            m_engine->mute(1, 2, vMute[5]);
         break;
 
         case A_TOGGLE_VOICE7:
             vMute[6] = !vMute[6];
-            m_engine.mute(2, 0, vMute[6]);
+            m_engine->mute(2, 0, vMute[6]);
         break;
 
         case A_TOGGLE_VOICE8:
             vMute[7] = !vMute[7];
-            m_engine.mute(2, 1, vMute[7]);
+            m_engine->mute(2, 1, vMute[7]);
         break;
 
         case A_TOGGLE_VOICE9:
             vMute[8] = !vMute[8];
-            m_engine.mute(2, 2, vMute[8]);
+            m_engine->mute(2, 2, vMute[8]);
         break;
 
         case A_TOGGLE_FILTER:
@@ -1182,6 +1581,11 @@ void ConsolePlayer::decodeKeys ()
             m_engCfg.sidEmulation->filter(m_filter.enabled);
         break;
 
+        case A_STATS:
+            cerr << endl;
+            pipelineStats(cerr);
+        break;
+
         case A_QUIT:
             m_state = playerFastExit;
             return;
@@ -26,7 +26,17 @@
 #  include "config.h"
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 #include <sidplayfp/SidTune.h>
 #include <sidplayfp/sidplayfp.h>
@@ -36,11 +46,20 @@
 
 #include "audio/IAudio.h"
 #include "audio/AudioConfig.h"
+#include "audio/AudioRing.h"
+#include "audio/AudioStats.h"
+#include "audio/Realtime.h"
 #include "audio/null/null.h"
 #include "IniConfig.h"
+#include "songlengthIndex.h"
 
 #include "sidlib_features.h"
 
+// Daemon mode needs Unix domain sockets
+#if defined(HAVE_SYS_SOCKET_H) && defined(HAVE_SYS_UN_H) && defined(HAVE_POLL_H)
+#  define HAVE_DAEMON
+#endif
+
 #ifdef HAVE_TSID
 #  if HAVE_TSID > 1
 #    include <tsid2/tsid2.h>
@@ -80,9 +99,17 @@ typedef enum
     /* Hardware */
     OUT_SOUNDCARD,
     /* File creation support */
-    OUT_WAV, OUT_AU, OUT_END
+    OUT_WAV, OUT_AU, OUT_FLAC, OUT_END
 } OUTPUTS;
 
+typedef enum
+{
+    /* Split the output of each tune */
+    STEMS_NONE = 0,
+    /* One file per voice or per SID chip */
+    STEMS_VOICES, STEMS_CHIPS
+} STEMS;
+
 // Error and status message numbers.
 enum
 {
@@ -101,6 +128,8 @@ typedef enum
 } sldb_t;
 
 void displayError (const char *arg0, unsigned int num);
+bool parseTime (const char *str, uint_least32_t &time);
+bool isPlaylist (const char *file);
 
 
 // Grouped global variables
@@ -124,15 +153,22 @@ private:
 #endif
 
     const char* const  m_name;
-    sidplayfp          m_engine;
+    std::unique_ptr<sidplayfp> m_engine; // Replaced by the crossfade one when it carries on
     SidConfig          m_engCfg;
-    SidTune            m_tune;
+    std::unique_ptr<SidTune> m_tune; // Replaced by a prefetched one in playlists
     player_state_t     m_state;
+    std::atomic<bool>  m_cancel;    // Set by stop(), polled by pre-rolls and batch workers
     const char*        m_outfile;
     std::string        m_filename;
 
     IniConfig          m_iniCfg;
     SidDatabase        m_database;
+    songlengthIndex    m_lengthIndex; // Used instead of m_database if available
+
+    // Kept around for the batch workers
+    std::unique_ptr<uint8_t[]> m_kernalRom;
+    std::unique_ptr<uint8_t[]> m_basicRom;
+    std::unique_ptr<uint8_t[]> m_chargenRom;
 
     double             m_fcurve;
 
@@ -158,6 +194,19 @@ private:
     int  m_channels;
     int  m_precision;
 
+    // Sound card buffering, 0 for the driver default
+    uint_least32_t m_latency;
+    uint_least32_t m_periods;
+
+    struct m_realtime_t
+    {
+        realtime::policy_t policy;
+        int                priority;  // Of the audio thread, emulation gets one less
+        bool               applied;   // Done once for the whole run
+        std::string        emulation; // What was obtained
+        std::string        memory;
+    } m_realtime;
+
     struct m_filter_t
     {
         // Filter parameter for reSID
@@ -176,14 +225,20 @@ private:
     {
         OUTPUTS        output;   // Selected output type
         SIDEMUS        sid;      // Sid emulation
+        SIDEMUS        built;    // Emulation the current builder was made for
         bool           file;     // File based driver
         bool           info;     // File metadata
         AudioConfig    cfg;
         IAudio*        selected; // Selected Output Driver
         IAudio*        device;   // HW/File Driver
+        audioRing*     ring;     // Sound card feeder, if any
+        bool           live;     // Sound card open, kept across tracks
         Audio_Null     null;     // Used for everything
     } m_driver;
 
+    // Time spent on each buffer, the device keeps its own part
+    audioStats         m_stats;
+
     struct m_timer_t
     {   // secs
         uint_least32_t start;
@@ -192,6 +247,8 @@ private:
         uint_least32_t length;
         bool           valid;
         bool           starting;
+        bool           switching;
+        std::chrono::steady_clock::time_point restart;
     } m_timer;
 
     struct m_track_t
@@ -209,6 +266,131 @@ private:
         uint_least8_t max;
     } m_speed;
 
+    struct m_fade_t
+    {
+        uint_least32_t length;   // ms, 0 disables
+        std::thread    worker;   // Renders the start of the next tune
+        std::atomic<bool> ready;
+        std::atomic<bool> cancel;
+        std::vector<short> head; // Faded in over the end of the playing tune
+        // Left by the worker where the head ends, to carry on with the next tune
+        std::unique_ptr<sidplayfp> engine;
+        sidbuilder    *builder;
+        std::unique_ptr<SidTune> tune;
+        int            channels;
+        bool           mute[9];  // Taken when the worker starts
+        int            entry;    // Playlist entry of the next tune, -1 for a subtune
+        uint_least16_t song;     // Of the next tune, as selected by the worker
+        bool           mixing;   // The head was ready when the fade began
+        size_t         position; // Head samples already mixed
+        uint_least64_t window;   // Samples faded over
+        uint_least64_t stopAt;   // Samples to play, 0 if not fading
+        uint_least64_t played;
+        uint_least64_t skip;     // Samples of the tune already played by the fade
+    } m_fade;
+
+    struct m_batch_t
+    {
+        std::vector<std::string> files;
+        unsigned int   jobs;     // Worker threads
+        unsigned int   shard;    // This machine's share, 1 based
+        unsigned int   shards;
+        bool           enabled;
+        STEMS          stems;
+        std::mutex     lock;     // Serializes database lookups, journal and console output
+        std::mutex     tuneLock; // Serializes loading a tune shared by the stems
+
+        std::atomic<unsigned int> next;
+        std::atomic<unsigned int> failed;
+        std::atomic<unsigned int> skipped;
+
+        // Jobs already done, as "md5 subtune config"
+        const char*    journal;
+        std::ofstream  journalFile;
+        std::unordered_set<std::string> done;
+        std::string    config;
+
+        // Output files claimed by the jobs so far
+        std::unordered_set<std::string> outputs;
+    } m_batch;
+
+    struct m_playlist_t
+    {
+        struct entry_t
+        {
+            std::string    file;
+            uint_least16_t song;     // 0 to follow the command line
+            uint_least32_t length;   // ms, 0 to follow the command line
+        };
+
+        // A loaded entry
+        struct tune_t
+        {
+            std::unique_ptr<SidTune> tune; // nullptr if failed
+            std::string    file;     // Resolved path
+            std::string    error;
+            std::vector<int_least32_t> lengths; // From the songlength DB, per subtune
+        };
+
+        std::vector<entry_t> entries;
+        std::string    dir;      // Of the playlist, ending with a separator
+        bool           enabled;
+        unsigned int   position; // Playing entry
+        int            pending;  // Entry to switch to on restart, -1 if none
+        int            step;     // Direction to skip unplayable entries
+        std::vector<int_least32_t> lengths; // Of the playing entry
+
+        // Command line settings, for entries without overrides
+        uint_least16_t first;
+        bool           single;
+        uint_least32_t length;
+        bool           valid;
+
+        // Upcoming entries are loaded ahead by a worker
+        std::thread    worker;
+        std::mutex     lock;
+        std::condition_variable wake;
+        std::map<unsigned int, tune_t> ready;
+        bool           quit;
+    } m_playlist;
+
+    struct m_bench_t
+    {
+        uint_least32_t seconds;  // Of audio per tune
+        bool           enabled;
+        bool           json;
+
+        // Engine and configuration matrix
+        bool           matrix;
+        unsigned int   repeat;   // Measured runs per cell
+        const char*    baseline; // Results to compare against
+        double         threshold;// Slowdown flagged, in percent
+    } m_bench;
+
+    // Outcome of a benchmarked tune
+    struct bench_t
+    {
+        std::string    file;
+        unsigned int   song;
+        std::string    builder;
+        int            channels;
+        unsigned int   chips;
+        double         audio;    // Seconds rendered
+        double         wall;     // Seconds taken
+        double         cpu;      // Seconds of processor time
+        std::string    error;
+    };
+
+    struct m_daemon_t
+    {
+        std::string    socket;   // Control socket path
+        bool           enabled;
+        std::atomic<bool> running;
+        int            listener;
+        // Connected clients and their unterminated input
+        std::vector<std::pair<int, std::string>> clients;
+    } m_daemon;
+
 private:
     // Console
     void consoleColour  (player_colour_t colour, bool bold);
@@ -220,10 +402,12 @@ private:
 
     bool createOutput   (OUTPUTS driver, const SidTuneInfo *tuneInfo);
     bool createSidEmu   (SIDEMUS emu, const SidTuneInfo *tuneInfo);
-    void displayError   (const char *error);
-    void displayError   (unsigned int num) { ::displayError (m_name, num); }
+    bool newSidEmu      (SIDEMUS emu, const SidTuneInfo *tuneInfo, sidbuilder *&builder) const;
+    void displayError   (const char *error) const;
+    void displayError   (unsigned int num) const { ::displayError (m_name, num); }
     void decodeKeys     (void);
     void updateDisplay();
+    void pipelineStats  (std::ostream &out);
     void emuflush       (void);
     void menu           (void);
     void refreshRegDump ();
@@ -232,10 +416,60 @@ private:
 
     const char *getNote(uint16_t freq);
 
-    std::string getFileName(const SidTuneInfo *tuneInfo, const char* ext);
+    std::string getFileName(const SidTuneInfo *tuneInfo, const char* ext) const;
+
+    int_least32_t songLength(SidTune &tune);
+    bool preRoll        (sidplayfp &engine, uint_least32_t startMs, const std::atomic<bool> *cancel = nullptr);
+
+    // Crossfade
+    void fadeStart      (void);
+    void fadeRender     (SidConfig cfg, std::string file, int entry, uint_least16_t song,
+                         uint_least32_t start, uint_least64_t length);
+    void fadeStop       (bool keep);
+    void fadeCancel     (void);
+    bool fadeFollows    (void);
+    void fadeAdopt      (void);
+    void fadeRelease    (void);
+    void fadeMix        (short *buffer, uint_least32_t size);
+
+    // Batch rendering
+    bool readList       (const char *listFile);
+    bool openJournal    (void);
+    std::string configHash () const;
+    void batchWorker    (void);
+    bool batchFile      (sidplayfp &engine, const std::string &fileName);
+    bool batchSong      (sidplayfp &engine, SidTune &tune, const bool mute[9], const char *suffix);
+    bool batchStems     (SidTune &tune);
+
+    // Benchmark
+    bool benchSong      (sidplayfp &engine, SidTune &tune, SIDEMUS emu,
+                         const SidConfig &config, int channels, bench_t &result);
+    void benchReport    (const bench_t &result, bool first) const;
+    bool benchMatrix    (sidplayfp &engine, std::vector<std::unique_ptr<SidTune>> &tunes);
+
+    // Playlists
+    bool readPlaylist   (const char *playlist);
+    bool playlistStart  (void);
+    bool playlistSelect (int index, int step);
+    bool playlistSwitch (void);
+    void playlistLoad   (unsigned int index, m_playlist_t::tune_t &tune);
+    void playlistWorker (void);
+    void playlistStop   (void);
+
+#ifdef HAVE_DAEMON
+    // Daemon mode
+    bool daemonListen   (void);
+    void daemonPoll     (int timeout);
+    void daemonCommand  (int fd, const std::string &line);
+    void daemonReply    (int fd, const std::string &reply) const;
+    bool daemonLoad     (const std::string &fileName, std::string &error);
+    bool daemonStart    (void);
+    void daemonStop     (void);
+#endif
 
-    inline bool tryOpenTune(const char *hvscBase);
+    bool tryOpenTune(const char *hvscBase);
     inline bool tryOpenDatabase(const char *hvscBase, const char *suffix);
+    bool openLengthIndex(const char *database);
 
 public:
     ConsolePlayer (const char * const name);
@@ -246,8 +480,16 @@ public:
     void close (void);
     bool play  (void);
     void stop  (void);
+    bool batch (void);
+    bool bench (void);
+#ifdef HAVE_DAEMON
+    bool daemon (void);
+#endif
 
     player_state_t state (void) const { return m_state; }
+    bool batchMode (void) const { return m_batch.enabled; }
+    bool benchMode (void) const { return m_bench.enabled; }
+    bool daemonMode (void) const { return m_daemon.enabled; }
 };
 
 #endif // PLAYER_H
@@ -0,0 +1,397 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "player.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+
+/*
+ * M3U and PLS playlists.
+ *
+ * Entries are played one after the other, each as if given on the
+ * command line. A subtune can be picked by appending "#<n>" to the
+ * file name, the length comes from #EXTINF or LengthN, and both
+ * replace the -o and -t settings for that entry only.
+ *
+ * A worker loads the next few entries ahead, including the md5 and
+ * songlength lookups of all their subtunes, so moving on to the
+ * next entry doesn't have to wait for the disk or the database.
+ */
+
+// Entries loaded ahead of the playing one
+#define PLAYLIST_PREFETCH 3
+
+// Wide-chars are not yet supported here
+#undef SEPARATOR
+#define SEPARATOR "/"
+
+namespace
+{
+
+std::string extension(const char *file)
+{
+    std::string ext;
+    const char *dot = strrchr(file, '.');
+    if (dot != nullptr)
+    {
+        while (*++dot)
+            ext.push_back(tolower(*dot));
+    }
+    return ext;
+}
+
+// Trailing "#<n>" subtune selection
+uint_least16_t parseSong(std::string &file)
+{
+    const size_t hash = file.find_last_of('#');
+    if ((hash == std::string::npos) || (hash + 1 == file.length())
+        || (file.find_first_not_of("0123456789", hash + 1) != std::string::npos))
+        return 0;
+
+    const uint_least16_t song = atoi(file.c_str() + hash + 1);
+    file.erase(hash);
+    return song;
+}
+
+// Length in seconds, zero or negative if unknown
+uint_least32_t parseSeconds(const char *str)
+{
+    const long seconds = strtol(str, nullptr, 10);
+    return seconds > 0 ? seconds * 1000 : 0;
+}
+
+}
+
+bool isPlaylist(const char *file)
+{
+    const std::string ext = extension(file);
+    return (ext == "m3u") || (ext == "m3u8") || (ext == "pls");
+}
+
+/**
+ * Read the entries of an M3U or PLS playlist
+ */
+bool ConsolePlayer::readPlaylist(const char *playlist)
+{
+    std::ifstream list(playlist);
+    if (!list.is_open())
+    {
+        displayError(ERR_FILE_OPEN);
+        return false;
+    }
+
+    // Where relative entries are found
+    std::string dir(playlist);
+    const size_t slash = dir.find_last_of(SEPARATOR);
+    dir.erase(slash == std::string::npos ? 0 : slash + 1);
+
+    const bool pls = extension(playlist) == "pls";
+
+    // PLS entries are numbered and may come in any order
+    std::map<unsigned int, m_playlist_t::entry_t> numbered;
+    uint_least32_t length = 0;
+
+    std::string line;
+    while (std::getline(list, line))
+    {
+        // Drop line endings from foreign systems and the utf-8 BOM
+        if (!line.empty() && (line.back() == '\r'))
+            line.pop_back();
+        if (line.compare(0, 3, "\xef\xbb\xbf") == 0)
+            line.erase(0, 3);
+
+        if (line.empty())
+            continue;
+
+        std::string file;
+        if (pls)
+        {
+            const size_t equal = line.find('=');
+            if (equal == std::string::npos)
+                continue;
+
+            const std::string key = line.substr(0, equal);
+            const unsigned int n = atoi(key.c_str() + strcspn(key.c_str(), "0123456789"));
+            if (key.compare(0, 4, "File") == 0)
+            {
+                file = line.substr(equal + 1);
+                numbered[n].song = parseSong(file);
+                numbered[n].file = file;
+            }
+            else if (key.compare(0, 6, "Length") == 0)
+            {
+                numbered[n].length = parseSeconds(line.c_str() + equal + 1);
+            }
+            continue;
+        }
+
+        if (line[0] == '#')
+        {   // #EXTINF:<seconds>,<title> describes the next entry
+            if (line.compare(0, 8, "#EXTINF:") == 0)
+                length = parseSeconds(line.c_str() + 8);
+            continue;
+        }
+
+        m_playlist_t::entry_t entry;
+        entry.file   = line;
+        entry.song   = parseSong(entry.file);
+        entry.length = length;
+        m_playlist.entries.push_back(entry);
+        length = 0;
+    }
+
+    for (auto &entry : numbered)
+    {
+        if (!entry.second.file.empty())
+            m_playlist.entries.push_back(entry.second);
+    }
+
+    if (m_playlist.entries.empty())
+    {
+        displayError("ERROR: Empty playlist");
+        return false;
+    }
+
+    m_playlist.dir     = dir;
+    m_playlist.enabled = true;
+    return true;
+}
+
+/**
+ * Load the first playable entry and start loading ahead.
+ * Called once the songlength database is open.
+ */
+bool ConsolePlayer::playlistStart()
+{
+    m_playlist.first  = m_track.first;
+    m_playlist.single = m_track.single;
+    m_playlist.length = m_timer.length;
+    m_playlist.valid  = m_timer.valid;
+
+    playlistSelect(0, 1);
+    if (!playlistSwitch())
+    {
+        displayError("ERROR: No playable tunes in playlist");
+        return false;
+    }
+
+    m_playlist.quit   = false;
+    m_playlist.worker = std::thread(&ConsolePlayer::playlistWorker, this);
+    return true;
+}
+
+void ConsolePlayer::playlistStop()
+{
+    if (!m_playlist.worker.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_playlist.lock);
+        m_playlist.quit = true;
+    }
+    m_playlist.wake.notify_one();
+    m_playlist.worker.join();
+}
+
+/**
+ * Queue the entry to play on the next restart,
+ * wrapping around when looping.
+ */
+bool ConsolePlayer::playlistSelect(int index, int step)
+{
+    const int entries = m_playlist.entries.size();
+    if ((index < 0) || (index >= entries))
+    {
+        if (!m_track.loop)
+            return false;
+        index = (index + entries) % entries;
+    }
+
+    m_playlist.pending = index;
+    m_playlist.step    = step;
+    return true;
+}
+
+/**
+ * Make the pending entry the playing one, moving on past
+ * any entry that fails to load.
+ */
+bool ConsolePlayer::playlistSwitch()
+{
+    for (size_t tries = 0; tries < m_playlist.entries.size(); tries++)
+    {
+        const unsigned int index = m_playlist.pending;
+
+        m_playlist_t::tune_t loaded;
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(m_playlist.lock);
+            auto it = m_playlist.ready.find(index);
+            if (it != m_playlist.ready.end())
+            {
+                loaded = std::move(it->second);
+                m_playlist.ready.erase(it);
+                found = true;
+            }
+        }
+
+        // Not loaded ahead, e.g. going backwards
+        if (!found)
+            playlistLoad(index, loaded);
+
+        if (loaded.tune)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_playlist.lock);
+                m_playlist.position = index;
+                m_playlist.pending  = -1;
+                // Forget entries the worker won't be asked for
+                for (auto it = m_playlist.ready.begin(); it != m_playlist.ready.end();)
+                {
+                    const unsigned int ahead = (it->first + m_playlist.entries.size() - index)
+                        % m_playlist.entries.size();
+                    if ((ahead == 0) || (ahead > PLAYLIST_PREFETCH))
+                        it = m_playlist.ready.erase(it);
+                    else
+                        ++it;
+                }
+            }
+            m_playlist.wake.notify_one();
+
+            m_tune.swap(loaded.tune);
+            m_filename.swap(loaded.file);
+            m_playlist.lengths.swap(loaded.lengths);
+
+            // Apply the entry's overrides
+            const m_playlist_t::entry_t &entry = m_playlist.entries[index];
+            m_track.single   = entry.song ? true : m_playlist.single;
+            m_track.first    = m_tune->selectSong(entry.song ? entry.song : m_playlist.first);
+            m_track.selected = m_track.first;
+            if (m_track.single)
+                m_track.songs = 1;
+            m_timer.valid    = entry.length ? true : m_playlist.valid;
+            m_timer.length   = entry.length ? entry.length : m_playlist.length;
+            return true;
+        }
+
+        if (m_quietLevel < 2)
+            cerr << m_name << ": " << loaded.file << ": " << loaded.error << endl;
+
+        if (!playlistSelect(index + m_playlist.step, m_playlist.step))
+            break;
+    }
+
+    m_playlist.pending = -1;
+    return false;
+}
+
+/**
+ * Load an entry, trying HVSC_BASE as tryOpenTune does,
+ * and look up the lengths of all its subtunes.
+ */
+void ConsolePlayer::playlistLoad(unsigned int index, m_playlist_t::tune_t &tune)
+{
+    const std::string &entry = m_playlist.entries[index].file;
+
+    // Relative entries are relative to the playlist
+    std::string file(entry);
+    if (entry.compare(0, 1, SEPARATOR) != 0)
+        file.insert(0, m_playlist.dir);
+
+    tune.tune.reset(new SidTune(file.c_str()));
+    tune.file = file;
+    if (!tune.tune->getStatus())
+    {
+        tune.error = tune.tune->statusString();
+
+        // HVSC paths may start with a separator too
+        const char* hvscBase = getenv("HVSC_BASE");
+        if (hvscBase)
+        {
+            tune.file.assign(hvscBase).append(SEPARATOR).append(entry);
+            tune.tune->load(tune.file.c_str());
+        }
+
+        if (!tune.tune->getStatus())
+        {
+            tune.tune.reset();
+            tune.file = file;
+            return;
+        }
+    }
+
+    if (songlengthDB != SLDB_NONE)
+    {
+        const unsigned int songs = tune.tune->getInfo()->songs();
+        for (unsigned int song = 1; song <= songs; song++)
+        {
+            tune.tune->selectSong(song);
+            tune.lengths.push_back(songLength(*tune.tune));
+        }
+    }
+}
+
+void ConsolePlayer::playlistWorker()
+{
+    // Loading ahead is not time critical, don't compete with playback
+    realtime::demote();
+
+    std::unique_lock<std::mutex> lock(m_playlist.lock);
+    while (!m_playlist.quit)
+    {
+        // Nearest upcoming entry not loaded yet
+        const unsigned int entries = m_playlist.entries.size();
+        int next = -1;
+        for (unsigned int ahead = 1; ahead <= PLAYLIST_PREFETCH; ahead++)
+        {
+            unsigned int index = m_playlist.position + ahead;
+            if (index >= entries)
+            {
+                if (!m_track.loop)
+                    break;
+                index %= entries;
+            }
+            if (m_playlist.ready.find(index) == m_playlist.ready.end())
+            {
+                next = index;
+                break;
+            }
+        }
+
+        if (next < 0)
+        {
+            m_playlist.wake.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        m_playlist_t::tune_t tune;
+        playlistLoad(next, tune);
+        lock.lock();
+
+        // Failed entries are kept too, to be skipped without retrying
+        m_playlist.ready[next] = std::move(tune);
+    }
+}
@@ -0,0 +1,1013 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+//
+// sidcatalog - build and query a catalog of a SID collection
+//
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
+
+#ifdef HAVE_SYS_MMAN_H
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#endif
+
+#include <sidplayfp/SidTune.h>
+#include <sidplayfp/SidTuneInfo.h>
+
+#include "codeConvert.h"
+#include "sidlib_features.h"
+#include "songlengthIndex.h"
+#include "utils.h"
+
+#include "sidcxx11.h"
+
+using namespace std;
+
+/*
+ * The catalog is stored by columns: a header, then one array per
+ * field with an entry for each tune, sorted by path. Strings are
+ * offsets into a pool of deduplicated, nul terminated strings, so
+ * authors and release lines shared by many tunes are stored once.
+ * A query only touches the columns it filters on.
+ */
+
+// Bump when the layout changes
+#define CATALOG_VERSION 1
+
+#define NO_LENGTHS 0xffffffff
+
+struct header_t
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t count;     // Number of tunes
+    uint32_t lengths;   // Number of song lengths
+    uint32_t poolSize;  // Size of the string pool
+    uint32_t root;      // Collection directory, offset into the pool
+    uint32_t reserved;
+};
+
+static const char CATALOG_MAGIC[8] = { 'S', 'I', 'D', 'C', 'A', 'T', '\0', '\0' };
+
+// Columns, in file order
+struct columns_t
+{
+    const uint32_t* path;
+    const uint32_t* title;
+    const uint32_t* author;
+    const uint32_t* released;
+    const uint32_t* lengthFirst; // Index of the first song's length or NO_LENGTHS
+    const int32_t*  lengths;     // ms, -1 if unknown
+    const uint8_t*  md5;         // 16 bytes per tune
+    const uint16_t* year;        // 0 if unknown
+    const uint16_t* songs;
+    const uint16_t* startSong;
+    const uint16_t* loadAddr;
+    const uint16_t* initAddr;
+    const uint16_t* playAddr;
+    const uint16_t* sid2Addr;
+    const uint16_t* sid3Addr;
+    const uint8_t*  clock;       // SidTuneInfo::clock_t
+    const uint8_t*  chips;
+    const uint8_t*  model1;      // SidTuneInfo::model_t
+    const uint8_t*  model2;
+    const uint8_t*  model3;
+    const char*     pool;
+};
+
+// One tune while building
+struct record_t
+{
+    bool            ok;
+    std::string     title;
+    std::string     author;
+    std::string     released;
+    uint8_t         md5[16];
+    uint16_t        year;
+    uint16_t        songs;
+    uint16_t        startSong;
+    uint16_t        loadAddr;
+    uint16_t        initAddr;
+    uint16_t        playAddr;
+    uint16_t        sid2Addr;
+    uint16_t        sid3Addr;
+    uint8_t         clock;
+    uint8_t         chips;
+    uint8_t         model[3];
+    std::vector<int32_t> lengths;
+};
+
+namespace
+{
+
+template<typename T>
+const T *column(const uint8_t *&ptr, size_t count)
+{
+    const T *col = reinterpret_cast<const T*>(ptr);
+    ptr += count * sizeof(T);
+    return col;
+}
+
+// Column pointers for a catalog in memory, returns the end of the last column
+const uint8_t *layout(const uint8_t *base, const header_t &header, columns_t &col)
+{
+    const size_t n = header.count;
+    const uint8_t *ptr = base + sizeof(header_t);
+    col.path        = column<uint32_t>(ptr, n);
+    col.title       = column<uint32_t>(ptr, n);
+    col.author      = column<uint32_t>(ptr, n);
+    col.released    = column<uint32_t>(ptr, n);
+    col.lengthFirst = column<uint32_t>(ptr, n);
+    col.lengths     = column<int32_t>(ptr, header.lengths);
+    col.md5         = column<uint8_t>(ptr, n * 16);
+    col.year        = column<uint16_t>(ptr, n);
+    col.songs       = column<uint16_t>(ptr, n);
+    col.startSong   = column<uint16_t>(ptr, n);
+    col.loadAddr    = column<uint16_t>(ptr, n);
+    col.initAddr    = column<uint16_t>(ptr, n);
+    col.playAddr    = column<uint16_t>(ptr, n);
+    col.sid2Addr    = column<uint16_t>(ptr, n);
+    col.sid3Addr    = column<uint16_t>(ptr, n);
+    col.clock       = column<uint8_t>(ptr, n);
+    col.chips       = column<uint8_t>(ptr, n);
+    col.model1      = column<uint8_t>(ptr, n);
+    col.model2      = column<uint8_t>(ptr, n);
+    col.model3      = column<uint8_t>(ptr, n);
+    col.pool        = column<char>(ptr, header.poolSize);
+    return ptr;
+}
+
+char toLowerAscii(char c)
+{
+    return (c < 'A' || c > 'Z') ? c : c + ('a' - 'A');
+}
+
+// Case insensitive substring search, needle must be lower case
+bool contains(const char *haystack, const std::string &needle)
+{
+    if (needle.empty())
+        return true;
+
+    for (; *haystack; haystack++)
+    {
+        size_t i = 0;
+        while ((i < needle.length()) && (toLowerAscii(haystack[i]) == needle[i]))
+            i++;
+        if (i == needle.length())
+            return true;
+    }
+    return false;
+}
+
+bool isTune(const char *name)
+{
+    const char *ext = strrchr(name, '.');
+    if (ext == nullptr)
+        return false;
+
+    std::string lower;
+    while (*++ext)
+        lower.push_back(toLowerAscii(*ext));
+
+    return (lower == "sid") || (lower == "psid") || (lower == "mus");
+}
+
+// Year from the released string, e.g. "1987 Hewson"
+uint16_t parseYear(const char *released)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        if ((released[i] < '0') || (released[i] > '9'))
+            return 0;
+    }
+    return atoi(std::string(released, 4).c_str());
+}
+
+const char *getModel(uint8_t model)
+{
+    switch (model)
+    {
+    default:
+    case SidTuneInfo::SIDMODEL_UNKNOWN:
+        return "UNKNOWN";
+    case SidTuneInfo::SIDMODEL_6581:
+        return "6581";
+    case SidTuneInfo::SIDMODEL_8580:
+        return "8580";
+    case SidTuneInfo::SIDMODEL_ANY:
+        return "ANY";
+    }
+}
+
+const char *getClock(uint8_t clock)
+{
+    switch (clock)
+    {
+    default:
+    case SidTuneInfo::CLOCK_UNKNOWN:
+        return "UNKNOWN";
+    case SidTuneInfo::CLOCK_PAL:
+        return "PAL";
+    case SidTuneInfo::CLOCK_NTSC:
+        return "NTSC";
+    case SidTuneInfo::CLOCK_ANY:
+        return "ANY";
+    }
+}
+
+bool isOption(const char *arg, const char *name, const char *&value)
+{
+    const size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0)
+        return false;
+    value = arg + len;
+    return true;
+}
+
+std::string defaultCatalog()
+{
+#ifndef _WIN32
+    try
+    {
+        return std::string(utils::getDataPath()).append("/sidplayfp/catalog");
+    }
+    catch (utils::error const &e) {}
+#endif
+    return std::string();
+}
+
+void printUsage()
+{
+    cout << "Syntax: sidcatalog build [options] <collection dir>" << endl
+         << "        sidcatalog query [options]" << endl
+         << "Common options:" << endl
+         << " -f<file>     catalog file (default: $XDG_DATA_HOME/sidplayfp/catalog)" << endl
+         << " -v           verbose output" << endl
+         << " -h, --help   display this screen" << endl
+         << "Build options:" << endl
+         << " -j<num>      number of threads (default: all cores)" << endl
+         << " -d<file>     songlength database (default: DOCUMENTS/Songlengths.md5" << endl
+         << "              in the collection or in HVSC_BASE)" << endl
+         << "Query options:" << endl
+         << " --title=<text>     title contains text" << endl
+         << " --author=<text>    author contains text" << endl
+         << " --released=<text>  released contains text" << endl
+         << " --search=<text>    title, author or released contain text" << endl
+         << " --year=<y>[-<y>]   released in year or range of years" << endl
+         << " --model=<6581|8580> SID model, tunes for any model always match" << endl
+         << " --chips=<num>      number of SID chips" << endl
+         << " --clock=<pal|ntsc> video standard, tunes for any clock always match" << endl
+         << " -l                 long listing, tab separated" << endl
+         << " --count            only print the number of matches" << endl;
+}
+
+/***********************************************************************
+ * Build
+ ***********************************************************************/
+
+// Create the missing directories leading to a file
+void createParents(const std::string &file)
+{
+#ifndef _WIN32
+    for (size_t pos = file.find('/', 1); pos != std::string::npos; pos = file.find('/', pos + 1))
+        mkdir(file.substr(0, pos).c_str(), 0755);
+#endif
+}
+
+// Directories already entered, symlinks may loop back
+typedef std::set<std::pair<dev_t, ino_t>> inodes_t;
+
+void walk(const std::string &root, const std::string &dir, std::vector<std::string> &files, inodes_t &visited)
+{
+    struct stat st;
+    if ((stat((root + dir).c_str(), &st) < 0)
+        || !visited.insert(std::make_pair(st.st_dev, st.st_ino)).second)
+        return;
+
+    DIR *d = opendir((root + dir).c_str());
+    if (d == nullptr)
+        return;
+
+    struct dirent *entry;
+    while ((entry = readdir(d)) != nullptr)
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        const std::string path = dir + '/' + entry->d_name;
+        if (stat((root + path).c_str(), &st) < 0)
+            continue;
+
+        if (S_ISDIR(st.st_mode))
+            walk(root, path, files, visited);
+        else if (S_ISREG(st.st_mode) && isTune(entry->d_name))
+            files.push_back(path);
+    }
+    closedir(d);
+}
+
+void loadTune(const std::string &file, const songlengthIndex &lengths, record_t &record)
+{
+    SidTune tune(file.c_str());
+    record.ok = tune.getStatus();
+    if (!record.ok)
+        return;
+
+    const SidTuneInfo *info = tune.getInfo();
+
+    const unsigned int strings = info->numberOfInfoStrings();
+    record.title    = (strings > 0) ? info->infoString(0) : "";
+    record.author   = (strings > 1) ? info->infoString(1) : "";
+    record.released = (strings > 2) ? info->infoString(2) : "";
+    record.year     = parseYear(record.released.c_str());
+
+    record.songs     = info->songs();
+    record.startSong = info->startSong();
+    record.loadAddr  = info->loadAddr();
+    record.initAddr  = info->initAddr();
+    record.playAddr  = info->playAddr();
+    record.clock     = info->clockSpeed();
+#ifdef FEAT_NEW_TUNEINFO_API
+    record.chips     = info->sidChips();
+    record.model[0]  = info->sidModel(0);
+    record.model[1]  = (record.chips > 1) ? info->sidModel(1) : SidTuneInfo::SIDMODEL_UNKNOWN;
+    record.model[2]  = (record.chips > 2) ? info->sidModel(2) : SidTuneInfo::SIDMODEL_UNKNOWN;
+    record.sid2Addr  = (record.chips > 1) ? info->sidChipBase(1) : 0;
+    record.sid3Addr  = (record.chips > 2) ? info->sidChipBase(2) : 0;
+#else
+    record.chips     = info->isStereo() ? 2 : 1;
+    record.model[0]  = info->sidModel1();
+    record.model[1]  = info->isStereo() ? info->sidModel2() : SidTuneInfo::SIDMODEL_UNKNOWN;
+    record.model[2]  = SidTuneInfo::SIDMODEL_UNKNOWN;
+    record.sid2Addr  = info->isStereo() ? info->sidChipBase2() : 0;
+    record.sid3Addr  = 0;
+#endif
+
+    char md5[SidTune::MD5_LENGTH + 1];
+#ifdef FEAT_NEW_SONLEGTH_DB
+    tune.createMD5New(md5);
+#else
+    tune.createMD5(md5);
+#endif
+    md5[SidTune::MD5_LENGTH] = '\0';
+    for (int i = 0; i < 16; i++)
+    {
+        record.md5[i] = strtoul(std::string(md5 + i * 2, 2).c_str(), nullptr, 16);
+    }
+
+#ifdef FEAT_NEW_SONLEGTH_DB
+    // Only the new style md5 matches the Songlengths.md5 database
+    if (lengths.isOpen() && (lengths.lengthMs(md5, 1) >= 0))
+    {
+        for (unsigned int song = 1; song <= record.songs; song++)
+            record.lengths.push_back(lengths.lengthMs(md5, song));
+    }
+#endif
+}
+
+class stringPool
+{
+private:
+    std::string m_pool;
+    std::unordered_map<std::string, uint32_t> m_offsets;
+
+public:
+    uint32_t add(const std::string &str)
+    {
+        auto it = m_offsets.find(str);
+        if (it != m_offsets.end())
+            return it->second;
+
+        const uint32_t offset = m_pool.size();
+        m_pool.append(str).push_back('\0');
+        m_offsets.emplace(str, offset);
+        return offset;
+    }
+
+    const std::string &data() const { return m_pool; }
+};
+
+template<typename T>
+void writeColumn(std::ofstream &out, const std::vector<T> &col)
+{
+    out.write(reinterpret_cast<const char*>(col.data()), col.size() * sizeof(T));
+}
+
+bool writeCatalog(const std::string &catalog, const std::string &root,
+                  const std::vector<std::string> &files, const std::vector<record_t> &records)
+{
+    stringPool pool;
+    std::vector<uint32_t> path, title, author, released, lengthFirst;
+    std::vector<int32_t>  lengths;
+    std::vector<uint8_t>  md5;
+    std::vector<uint16_t> year, songs, startSong, loadAddr, initAddr, playAddr, sid2Addr, sid3Addr;
+    std::vector<uint8_t>  clock, chips, model1, model2, model3;
+
+    const uint32_t rootOffset = pool.add(root);
+
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const record_t &r = records[i];
+        if (!r.ok)
+            continue;
+
+        path.push_back(pool.add(files[i]));
+        title.push_back(pool.add(r.title));
+        author.push_back(pool.add(r.author));
+        released.push_back(pool.add(r.released));
+        lengthFirst.push_back(r.lengths.empty() ? NO_LENGTHS : lengths.size());
+        lengths.insert(lengths.end(), r.lengths.begin(), r.lengths.end());
+        md5.insert(md5.end(), r.md5, r.md5 + 16);
+        year.push_back(r.year);
+        songs.push_back(r.songs);
+        startSong.push_back(r.startSong);
+        loadAddr.push_back(r.loadAddr);
+        initAddr.push_back(r.initAddr);
+        playAddr.push_back(r.playAddr);
+        sid2Addr.push_back(r.sid2Addr);
+        sid3Addr.push_back(r.sid3Addr);
+        clock.push_back(r.clock);
+        chips.push_back(r.chips);
+        model1.push_back(r.model[0]);
+        model2.push_back(r.model[1]);
+        model3.push_back(r.model[2]);
+    }
+
+    header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+    header.version  = CATALOG_VERSION;
+    header.count    = path.size();
+    header.lengths  = lengths.size();
+    header.poolSize = pool.data().size();
+    header.root     = rootOffset;
+
+    // Write to a private file and move it in place,
+    // so that queries never see a partial catalog
+    const std::string tmpFile = catalog + '.' + std::to_string(getpid());
+    std::ofstream out(tmpFile, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeColumn(out, path);
+    writeColumn(out, title);
+    writeColumn(out, author);
+    writeColumn(out, released);
+    writeColumn(out, lengthFirst);
+    writeColumn(out, lengths);
+    writeColumn(out, md5);
+    writeColumn(out, year);
+    writeColumn(out, songs);
+    writeColumn(out, startSong);
+    writeColumn(out, loadAddr);
+    writeColumn(out, initAddr);
+    writeColumn(out, playAddr);
+    writeColumn(out, sid2Addr);
+    writeColumn(out, sid3Addr);
+    writeColumn(out, clock);
+    writeColumn(out, chips);
+    writeColumn(out, model1);
+    writeColumn(out, model2);
+    writeColumn(out, model3);
+    out.write(pool.data().data(), pool.data().size());
+    out.close();
+
+    if (out.fail() || (rename(tmpFile.c_str(), catalog.c_str()) < 0))
+    {
+        unlink(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+int build(int argc, char **argv, std::string catalog, bool verbose)
+{
+    unsigned int jobs = std::thread::hardware_concurrency();
+    const char *database = nullptr;
+    std::string root;
+
+    for (int i = 0; i < argc; i++)
+    {
+        const char *value;
+        if (isOption(argv[i], "-j", value))
+        {
+            jobs = atoi(value);
+            if (jobs == 0)
+                jobs = std::thread::hardware_concurrency();
+        }
+        else if (isOption(argv[i], "-d", value) && *value)
+        {
+            database = value;
+        }
+        else if ((argv[i][0] != '-') && root.empty())
+        {
+            root = argv[i];
+        }
+        else
+        {
+            cerr << "ERROR: Unknown argument: '" << argv[i] << "'" << endl;
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (root.empty())
+    {
+        cerr << "ERROR: No collection directory given" << endl;
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+#ifndef _WIN32
+    // Queries can be run from anywhere
+    char *path = realpath(root.c_str(), nullptr);
+    if (path)
+        root = path;
+    free(path);
+#endif
+    while ((root.length() > 1) && (root.back() == '/'))
+        root.pop_back();
+
+    std::vector<std::string> files;
+    inodes_t visited;
+    walk(root, "", files, visited);
+    if (files.empty())
+    {
+        cerr << "ERROR: No tunes found in " << root << endl;
+        return EXIT_FAILURE;
+    }
+    std::sort(files.begin(), files.end());
+
+    songlengthIndex lengths;
+    {
+        std::string songlengths;
+        if (database)
+        {
+            songlengths = database;
+        }
+        else
+        {
+            struct stat st;
+            songlengths = root + "/DOCUMENTS/Songlengths.md5";
+            const char *hvscBase = getenv("HVSC_BASE");
+            if ((stat(songlengths.c_str(), &st) < 0) && hvscBase)
+                songlengths = std::string(hvscBase) + "/DOCUMENTS/Songlengths.md5";
+        }
+
+        if (!lengths.open(songlengths.c_str()) && (database || verbose))
+            cerr << "Songlength database not available: " << lengths.error() << endl;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<record_t> records(files.size());
+    std::atomic<unsigned int> next(0);
+
+    jobs = std::max(1u, std::min<unsigned int>(jobs, files.size()));
+    std::vector<std::thread> workers;
+    for (unsigned int j = 0; j < jobs; j++)
+    {
+        workers.emplace_back([&]()
+        {
+            unsigned int i;
+            while ((i = next++) < files.size())
+                loadTune(root + files[i], lengths, records[i]);
+        });
+    }
+
+    for (std::thread &worker : workers)
+        worker.join();
+
+    unsigned int failed = 0;
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        if (!records[i].ok)
+        {
+            failed++;
+            if (verbose)
+                cerr << "Unable to load " << root << files[i] << endl;
+        }
+    }
+
+    createParents(catalog);
+    if (!writeCatalog(catalog, root, files, records))
+    {
+        cerr << "ERROR: Unable to write " << catalog << endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    cerr << "Cataloged " << (files.size() - failed) << " of " << files.size() << " tunes in "
+         << std::setprecision(1) << std::fixed << elapsed.count() << "s using "
+         << jobs << (jobs == 1 ? " thread" : " threads") << endl;
+
+    return EXIT_SUCCESS;
+}
+
+/***********************************************************************
+ * Query
+ ***********************************************************************/
+
+class catalogFile
+{
+private:
+    const uint8_t*       m_map;
+    size_t               m_size;
+    std::vector<uint8_t> m_buffer;
+
+public:
+    header_t  header;
+    columns_t col;
+
+public:
+    catalogFile() : m_map(nullptr), m_size(0) {}
+
+    ~catalogFile()
+    {
+#ifdef HAVE_SYS_MMAN_H
+        if (m_map && m_buffer.empty())
+            munmap(const_cast<uint8_t*>(m_map), m_size);
+#endif
+    }
+
+    bool open(const std::string &file)
+    {
+#ifdef HAVE_SYS_MMAN_H
+        const int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        void *map = MAP_FAILED;
+        if ((fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(header_t)))
+            map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED)
+            return false;
+
+        m_map  = static_cast<const uint8_t*>(map);
+        m_size = st.st_size;
+#else
+        std::ifstream in(file, std::ios::binary);
+        if (!in.is_open())
+            return false;
+
+        m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if (m_buffer.size() < sizeof(header_t))
+            return false;
+
+        m_map  = m_buffer.data();
+        m_size = m_buffer.size();
+#endif
+
+        memcpy(&header, m_map, sizeof(header));
+        return (memcmp(header.magic, CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) == 0)
+            && (header.version == CATALOG_VERSION)
+            && (layout(m_map, header, col) == m_map + m_size)
+            && (m_size > 0) && (m_map[m_size - 1] == '\0')
+            && valid();
+    }
+
+    const char *string(uint32_t offset) const { return col.pool + offset; }
+
+private:
+    // Offsets must stay inside the file, the pool ends with a terminator
+    bool valid() const
+    {
+        if (header.root >= header.poolSize)
+            return false;
+
+        for (uint32_t i = 0; i < header.count; i++)
+        {
+            if ((col.path[i] >= header.poolSize)
+                || (col.title[i] >= header.poolSize)
+                || (col.author[i] >= header.poolSize)
+                || (col.released[i] >= header.poolSize))
+                return false;
+
+            if ((col.lengthFirst[i] != NO_LENGTHS)
+                && ((uint64_t)col.lengthFirst[i] + col.songs[i] > header.lengths))
+                return false;
+        }
+        return true;
+    }
+};
+
+struct filter_t
+{
+    std::string title;
+    std::string author;
+    std::string released;
+    std::string search;
+    unsigned int yearFrom;
+    unsigned int yearTo;
+    int model;
+    int chips;
+    int clock;
+};
+
+bool matches(const catalogFile &cat, const filter_t &filter, uint32_t i)
+{
+    const columns_t &col = cat.col;
+
+    // Cheap numeric columns first
+    if (filter.yearFrom && ((col.year[i] < filter.yearFrom) || (col.year[i] > filter.yearTo)))
+        return false;
+
+    if ((filter.chips > 0) && (col.chips[i] != filter.chips))
+        return false;
+
+    if ((filter.clock >= 0) && (col.clock[i] != filter.clock) && (col.clock[i] != SidTuneInfo::CLOCK_ANY))
+        return false;
+
+    if (filter.model >= 0)
+    {
+        bool found = false;
+        const uint8_t *models[3] = { col.model1, col.model2, col.model3 };
+        for (int chip = 0; chip < col.chips[i] && chip < 3; chip++)
+        {
+            const uint8_t model = models[chip][i];
+            found |= (model == filter.model) || (model == SidTuneInfo::SIDMODEL_ANY);
+        }
+        if (!found)
+            return false;
+    }
+
+    if (!contains(cat.string(col.title[i]), filter.title)
+        || !contains(cat.string(col.author[i]), filter.author)
+        || !contains(cat.string(col.released[i]), filter.released))
+        return false;
+
+    return filter.search.empty()
+        || contains(cat.string(col.title[i]), filter.search)
+        || contains(cat.string(col.author[i]), filter.search)
+        || contains(cat.string(col.released[i]), filter.search);
+}
+
+void printLength(int32_t ms)
+{
+    if (ms < 0)
+    {
+        cout << "?";
+        return;
+    }
+    cout << (ms / 60000) << ':' << std::setw(2) << std::setfill('0') << ((ms / 1000) % 60)
+         << '.' << std::setw(3) << (ms % 1000) << std::setfill(' ');
+}
+
+void printDetails(const catalogFile &cat, codeConvert &cvt, uint32_t i)
+{
+    const columns_t &col = cat.col;
+
+    cout << cat.string(cat.header.root) << cat.string(col.path[i]);
+    cout << '\t' << cvt.convert(cat.string(col.title[i]));
+    cout << '\t' << cvt.convert(cat.string(col.author[i]));
+    cout << '\t' << cvt.convert(cat.string(col.released[i]));
+    cout << '\t' << col.songs[i] << '\t' << col.startSong[i];
+    cout << '\t' << getClock(col.clock[i]);
+
+    cout << '\t' << getModel(col.model1[i]);
+    if (col.chips[i] > 1)
+        cout << ',' << getModel(col.model2[i]);
+    if (col.chips[i] > 2)
+        cout << ',' << getModel(col.model3[i]);
+
+    cout << std::hex << std::setfill('0');
+    cout << "\t$" << std::setw(4) << col.loadAddr[i]
+         << ",$" << std::setw(4) << col.initAddr[i]
+         << ",$" << std::setw(4) << col.playAddr[i];
+    if (col.chips[i] > 1)
+        cout << "\t$" << std::setw(4) << col.sid2Addr[i];
+    if (col.chips[i] > 2)
+        cout << ",$" << std::setw(4) << col.sid3Addr[i];
+    if (col.chips[i] < 2)
+        cout << '\t';
+
+    cout << '\t';
+    for (int b = 0; b < 16; b++)
+        cout << std::setw(2) << (unsigned int)col.md5[i * 16 + b];
+    cout << std::dec << std::setfill(' ');
+
+    cout << '\t';
+    if (col.lengthFirst[i] != NO_LENGTHS)
+    {
+        for (unsigned int song = 0; song < col.songs[i]; song++)
+        {
+            if (song)
+                cout << ' ';
+            printLength(col.lengths[col.lengthFirst[i] + song]);
+        }
+    }
+    cout << '\n';
+}
+
+std::string lower(const char *str)
+{
+    std::string result;
+    while (*str)
+        result.push_back(toLowerAscii(*str++));
+    return result;
+}
+
+int query(int argc, char **argv, const std::string &catalog, bool verbose)
+{
+    filter_t filter;
+    filter.yearFrom = 0;
+    filter.yearTo   = 0;
+    filter.model    = -1;
+    filter.chips    = 0;
+    filter.clock    = -1;
+    bool details = false;
+    bool count = false;
+
+    for (int i = 0; i < argc; i++)
+    {
+        const char *value;
+        bool valid = true;
+        if (isOption(argv[i], "--title=", value))
+            filter.title = lower(value);
+        else if (isOption(argv[i], "--author=", value))
+            filter.author = lower(value);
+        else if (isOption(argv[i], "--released=", value))
+            filter.released = lower(value);
+        else if (isOption(argv[i], "--search=", value))
+            filter.search = lower(value);
+        else if (isOption(argv[i], "--year=", value))
+        {
+            char *end;
+            filter.yearFrom = strtoul(value, &end, 10);
+            filter.yearTo = (*end == '-') ? strtoul(end + 1, &end, 10) : filter.yearFrom;
+            valid = (*end == '\0') && filter.yearFrom && (filter.yearTo >= filter.yearFrom);
+        }
+        else if (isOption(argv[i], "--model=", value))
+        {
+            if (strcmp(value, "6581") == 0)
+                filter.model = SidTuneInfo::SIDMODEL_6581;
+            else if (strcmp(value, "8580") == 0)
+                filter.model = SidTuneInfo::SIDMODEL_8580;
+            else
+                valid = false;
+        }
+        else if (isOption(argv[i], "--chips=", value))
+        {
+            filter.chips = atoi(value);
+            valid = (filter.chips >= 1) && (filter.chips <= 3);
+        }
+        else if (isOption(argv[i], "--clock=", value))
+        {
+            const std::string clock = lower(value);
+            if (clock == "pal")
+                filter.clock = SidTuneInfo::CLOCK_PAL;
+            else if (clock == "ntsc")
+                filter.clock = SidTuneInfo::CLOCK_NTSC;
+            else
+                valid = false;
+        }
+        else if (strcmp(argv[i], "-l") == 0)
+            details = true;
+        else if (strcmp(argv[i], "--count") == 0)
+            count = true;
+        else
+        {
+            cerr << "ERROR: Unknown argument: '" << argv[i] << "'" << endl;
+            printUsage();
+            return EXIT_FAILURE;
+        }
+
+        if (!valid)
+        {
+            cerr << "ERROR: Invalid value: '" << argv[i] << "'" << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    catalogFile cat;
+    if (!cat.open(catalog))
+    {
+        cerr << "ERROR: Unable to read catalog " << catalog << endl;
+        return EXIT_FAILURE;
+    }
+
+    codeConvert cvt;
+    const char *root = cat.string(cat.header.root);
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < cat.header.count; i++)
+    {
+        if (!matches(cat, filter, i))
+            continue;
+
+        found++;
+        if (count)
+            continue;
+
+        if (details)
+            printDetails(cat, cvt, i);
+        else
+            cout << root << cat.string(cat.col.path[i]) << '\n';
+    }
+
+    if (count)
+        cout << found << endl;
+
+    if (verbose)
+    {
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        cerr << found << " of " << cat.header.count << " tunes matched in "
+             << std::setprecision(1) << std::fixed << elapsed.count() << "ms" << endl;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+    if ((argc < 2) || (strcmp(argv[1], "-h") == 0) || (strcmp(argv[1], "--help") == 0))
+    {
+        printUsage();
+        return (argc < 2) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    const std::string command(argv[1]);
+    if ((command != "build") && (command != "query"))
+    {
+        cerr << "ERROR: Unknown command: '" << command << "'" << endl;
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    // Pick the common options, pass on the rest
+    std::string catalog = defaultCatalog();
+    bool verbose = false;
+    std::vector<char*> args;
+    for (int i = 2; i < argc; i++)
+    {
+        const char *value;
+        if (isOption(argv[i], "-f", value) && *value)
+            catalog = value;
+        else if (strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else if ((strcmp(argv[i], "-h") == 0) || (strcmp(argv[i], "--help") == 0))
+        {
+            printUsage();
+            return EXIT_SUCCESS;
+        }
+        else
+            args.push_back(argv[i]);
+    }
+
+    if (catalog.empty())
+    {
+        cerr << "ERROR: No catalog file given" << endl;
+        return EXIT_FAILURE;
+    }
+
+    return (command == "build")
+        ? build(args.size(), args.data(), catalog, verbose)
+        : query(args.size(), args.data(), catalog, verbose);
+}
@@ -0,0 +1,324 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "songlengthIndex.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef HAVE_SYS_MMAN_H
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+#endif
+
+#include "utils.h"
+
+// Bump when the layout changes
+#define INDEX_VERSION 1
+
+struct songlengthIndex::header_t
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t count;      // Number of entries
+    uint32_t lengths;    // Number of lengths
+    uint32_t reserved;
+    uint64_t sourceSize; // Size of the text database
+    int64_t  sourceTime; // Modification time of the text database
+};
+
+struct songlengthIndex::entry_t
+{
+    uint8_t  md5[16];
+    uint32_t first;      // Index of the first song's length
+    uint32_t songs;
+};
+
+static const char INDEX_MAGIC[8] = { 'S', 'L', 'D', 'B', 'I', 'D', 'X', '\0' };
+
+namespace
+{
+
+int hexValue(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+        return c - '0';
+    if ((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    if ((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool parseMd5(const char *str, uint8_t md5[16])
+{
+    for (int i = 0; i < 16; i++)
+    {
+        const int hi = hexValue(str[i * 2]);
+        const int lo = hexValue(str[i * 2 + 1]);
+        if ((hi < 0) || (lo < 0))
+            return false;
+        md5[i] = (hi << 4) | lo;
+    }
+    return true;
+}
+
+// Parse a "mm:ss[.SSS]" time stamp, -1 if invalid
+int32_t parseLength(const char *&str)
+{
+    char *end;
+    const long minutes = strtol(str, &end, 10);
+    if ((end == str) || (*end != ':'))
+        return -1;
+
+    str = end + 1;
+    const long seconds = strtol(str, &end, 10);
+    if (end == str)
+        return -1;
+    str = end;
+
+    long milliseconds = 0;
+    if (*str == '.')
+    {
+        int scale = 100;
+        while ((*++str >= '0') && (*str <= '9'))
+        {
+            milliseconds += (*str - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    // Skip attributes found in older databases, e.g. "(G)"
+    if (*str == '(')
+    {
+        while (*str && (*str++ != ')')) {}
+    }
+
+    return (minutes * 60 + seconds) * 1000 + milliseconds;
+}
+
+}
+
+songlengthIndex::songlengthIndex() :
+    m_map(nullptr),
+    m_size(0),
+    m_entries(nullptr),
+    m_lengths(nullptr),
+    m_count(0) {}
+
+songlengthIndex::~songlengthIndex()
+{
+    close();
+}
+
+void songlengthIndex::close()
+{
+#ifdef HAVE_SYS_MMAN_H
+    if (m_map != nullptr)
+        munmap(const_cast<uint8_t*>(m_map), m_size);
+#endif
+    m_map = nullptr;
+    m_size = 0;
+    m_entries = nullptr;
+    m_lengths = nullptr;
+    m_count = 0;
+}
+
+#ifdef HAVE_SYS_MMAN_H
+
+bool songlengthIndex::open(const char *database)
+{
+    close();
+
+    struct stat st;
+    if (stat(database, &st) < 0)
+    {
+        m_error = strerror(errno);
+        return false;
+    }
+
+    std::string indexFile;
+    try
+    {
+        indexFile = utils::getCacheFile("songlengths", database);
+    }
+    catch (utils::error const &e)
+    {
+        m_error = "Cannot get cache path";
+        return false;
+    }
+
+    if (map(indexFile, st.st_size, st.st_mtime))
+        return true;
+
+    return build(database, indexFile, st.st_size, st.st_mtime)
+        && map(indexFile, st.st_size, st.st_mtime);
+}
+
+bool songlengthIndex::map(const std::string &indexFile, uint64_t size, int64_t mtime)
+{
+    const int fd = ::open(indexFile.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    void *map = MAP_FAILED;
+    if ((fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(header_t)))
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    m_map  = static_cast<const uint8_t*>(map);
+    m_size = st.st_size;
+
+    // Reject stale or foreign indexes
+    const header_t *header = reinterpret_cast<const header_t*>(m_map);
+    if ((memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+        || (header->version != INDEX_VERSION)
+        || (header->sourceSize != size)
+        || (header->sourceTime != mtime)
+        || (m_size != sizeof(header_t) + (size_t)header->count * sizeof(entry_t)
+                      + (size_t)header->lengths * sizeof(int32_t)))
+    {
+        close();
+        return false;
+    }
+
+    m_count   = header->count;
+    m_entries = reinterpret_cast<const entry_t*>(m_map + sizeof(header_t));
+    m_lengths = reinterpret_cast<const int32_t*>(m_entries + m_count);
+    return true;
+}
+
+bool songlengthIndex::build(const char *database, const std::string &indexFile, uint64_t size, int64_t mtime)
+{
+    std::ifstream in(database);
+    if (!in.is_open())
+    {
+        m_error = strerror(errno);
+        return false;
+    }
+
+    std::vector<entry_t> entries;
+    std::vector<int32_t> lengths;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        // md5=length length ...
+        entry_t entry;
+        if ((line.length() < 34) || (line[32] != '=') || !parseMd5(line.c_str(), entry.md5))
+            continue;
+
+        entry.first = lengths.size();
+        const char *str = line.c_str() + 33;
+        for (;;)
+        {
+            while (*str == ' ')
+                str++;
+            if ((*str == '\0') || (*str == '\r'))
+                break;
+            const int32_t length = parseLength(str);
+            if (length < 0)
+                break;
+            lengths.push_back(length);
+        }
+        entry.songs = lengths.size() - entry.first;
+        entries.push_back(entry);
+    }
+
+    // Keep the first of any duplicate entries
+    std::stable_sort(entries.begin(), entries.end(),
+        [](const entry_t &a, const entry_t &b) { return memcmp(a.md5, b.md5, 16) < 0; });
+    entries.erase(std::unique(entries.begin(), entries.end(),
+        [](const entry_t &a, const entry_t &b) { return memcmp(a.md5, b.md5, 16) == 0; }),
+        entries.end());
+
+    header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version    = INDEX_VERSION;
+    header.count      = entries.size();
+    header.lengths    = lengths.size();
+    header.sourceSize = size;
+    header.sourceTime = mtime;
+
+    // Write to a private file and move it in place, so that
+    // concurrent players never map a partial index
+    const std::string tmpFile = indexFile + '.' + std::to_string(getpid());
+    {
+        std::ofstream out(tmpFile, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(entry_t));
+        out.write(reinterpret_cast<const char*>(lengths.data()), lengths.size() * sizeof(int32_t));
+        out.close();
+        if (out.fail())
+        {
+            m_error = "Unable to write songlength index";
+            unlink(tmpFile.c_str());
+            return false;
+        }
+    }
+
+    if (rename(tmpFile.c_str(), indexFile.c_str()) < 0)
+    {
+        m_error = strerror(errno);
+        unlink(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+#else
+
+bool songlengthIndex::open(const char*)
+{
+    m_error = "Songlength index not supported";
+    return false;
+}
+
+#endif // HAVE_SYS_MMAN_H
+
+int_least32_t songlengthIndex::lengthMs(const char *md5, unsigned int song) const
+{
+    uint8_t key[16];
+    if ((m_map == nullptr) || !parseMd5(md5, key))
+        return -1;
+
+    const entry_t *end = m_entries + m_count;
+    const entry_t *entry = std::lower_bound(m_entries, end, key,
+        [](const entry_t &e, const uint8_t *k) { return memcmp(e.md5, k, 16) < 0; });
+    if ((entry == end) || (memcmp(entry->md5, key, 16) != 0))
+        return -1;
+
+    if ((song < 1) || (song > entry->songs))
+        return -1;
+
+    return m_lengths[entry->first + song - 1];
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SONGLENGTHINDEX_H
+#define SONGLENGTHINDEX_H
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Binary index of a Songlengths.md5 database.
+ *
+ * The text database is converted once into a table of md5 sums
+ * sorted for binary search, followed by the song lengths in ms.
+ * The index is stored in the cache directory, rebuilt when the size
+ * or modification time of the database change, and memory mapped
+ * read only so concurrent players share a single copy.
+ */
+class songlengthIndex
+{
+private:
+    struct header_t;
+    struct entry_t;
+
+    const uint8_t*  m_map;
+    size_t          m_size;
+
+    const entry_t*  m_entries;
+    const int32_t*  m_lengths;
+    uint32_t        m_count;
+
+    std::string     m_error;
+
+private:
+    bool map(const std::string &indexFile, uint64_t size, int64_t mtime);
+    bool build(const char *database, const std::string &indexFile, uint64_t size, int64_t mtime);
+
+public:
+    songlengthIndex();
+    ~songlengthIndex();
+
+    /**
+     * Map the index of a Songlengths.md5 file,
+     * building it first if missing or stale.
+     */
+    bool open(const char *database);
+    void close();
+
+    bool isOpen() const { return m_map != nullptr; }
+
+    /**
+     * Get the length of a song.
+     *
+     * @param md5 the tune's md5 as hex string
+     * @param song the song number, starting at 1
+     * @return the length in ms, -1 if not found
+     */
+    int_least32_t lengthMs(const char *md5, unsigned int song) const;
+
+    const char *error() const { return m_error.c_str(); }
+};
+
+#endif
@@ -0,0 +1,556 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "stilIndex.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#ifdef HAVE_SYS_MMAN_H
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#  include <unistd.h>
+#endif
+
+#include "utils.h"
+
+// Bump when the layout changes
+#define INDEX_VERSION 2
+
+#define PATH_TO_STIL    "/DOCUMENTS/STIL.txt"
+#define PATH_TO_BUGLIST "/DOCUMENTS/BUGlist.txt"
+
+// Field tags as matched by the STIL library
+#define NAME_STR    "   NAME: "
+#define AUTHOR_STR  " AUTHOR: "
+#define TITLE_STR   "  TITLE: "
+#define ARTIST_STR  " ARTIST: "
+#define COMMENT_STR "COMMENT: "
+
+struct stilIndex::header_t
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t stilCount;
+    uint32_t bugCount;
+    uint32_t keysSize;
+    uint32_t textSize;
+    uint32_t reserved;
+    uint64_t stilSize;
+    int64_t  stilTime;
+    uint64_t bugSize;    // Zero if there is no BUGlist.txt
+    int64_t  bugTime;
+};
+
+struct stilIndex::entry_t
+{
+    uint32_t key;        // Offset of the lower case path in the key pool
+    uint32_t keyLength;
+    uint32_t tune;       // 0 for the whole entry
+    uint32_t offset;     // Text, lines ending with a newline
+    uint32_t length;
+    uint32_t multi;      // Whole entry only, split in tune sections
+    uint32_t head;       // Whole entry only, length before the first section
+};
+
+static const char INDEX_MAGIC[8] = { 'S', 'T', 'I', 'L', 'I', 'D', 'X', '\0' };
+
+namespace
+{
+
+struct item_t
+{
+    std::string key;
+    uint32_t    tune;
+    std::string text;
+    uint32_t    multi;
+    uint32_t    head;
+};
+
+std::string toLower(std::string str)
+{
+    for (char &c : str)
+    {
+        if ((c >= 'A') && (c <= 'Z'))
+            c += 'a' - 'A';
+    }
+    return str;
+}
+
+bool readFile(const std::string &fileName, std::string &text)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    if (!in.is_open())
+        return false;
+    text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+// Add an entry and its tune sections, each starting
+// with a (#n) line
+void addEntry(const std::vector<std::string> &lines, std::vector<item_t> &items)
+{
+    std::string key(lines[0]);
+    while (!key.empty() && (key.back() == ' '))
+        key.pop_back();
+    key = toLower(key);
+
+    const size_t whole = items.size();
+    items.push_back({ key, 0, lines[0] + '\n', 0, 0 });
+
+    std::string body;
+    for (size_t i = 1; i < lines.size(); i++)
+    {
+        const std::string &line = lines[i];
+        if (line.compare(0, 2, "(#") == 0)
+        {
+            if (!items[whole].multi)
+            {
+                items[whole].multi = 1;
+                items[whole].head  = body.length();
+            }
+
+            char *end;
+            const long tune = strtol(line.c_str() + 2, &end, 10);
+            if ((tune > 0) && (*end == ')'))
+                items.push_back({ key, (uint32_t)tune, std::string(), 0, 0 });
+            else
+                items.push_back({ std::string(), 0, std::string(), 0, 0 });
+        }
+        else if (items.size() > whole + 1)
+            items.back().text.append(line).append(1, '\n');
+
+        body.append(line).append(1, '\n');
+    }
+    items[whole].text.append(body);
+
+    // Drop the sections without a valid number
+    items.erase(std::remove_if(items.begin() + whole, items.end(),
+        [](const item_t &item) { return item.key.empty(); }), items.end());
+}
+
+// Find the entries, each starting with its path and
+// running up to the first blank line
+void scan(const std::string &text, bool stil, std::vector<item_t> &items)
+{
+    std::vector<std::string> lines;
+
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        const size_t eol = text.find('\n', pos);
+        const size_t next = (eol == std::string::npos) ? text.size() : eol + 1;
+        size_t end = (eol == std::string::npos) ? text.size() : eol;
+        if ((end > pos) && (text[end - 1] == '\r'))
+            end--;
+
+        const bool separator = stil && (text.compare(pos, 4, "### ") == 0);
+        if (separator || (end == pos) || (text[pos] == '/'))
+        {
+            if (!lines.empty())
+                addEntry(lines, items);
+            lines.clear();
+        }
+
+        if (!separator && (end > pos) && (!lines.empty() || (text[pos] == '/')))
+            lines.push_back(text.substr(pos, end - pos));
+
+        pos = next;
+    }
+
+    if (!lines.empty())
+        addEntry(lines, items);
+}
+
+const char *search(const char *start, const char *end, const char *str)
+{
+    const char *found = std::search(start, end, str, str + strlen(str));
+    return (found == end) ? nullptr : found;
+}
+
+// A single field of an entry or tune section, up to the next one
+bool getOneField(std::string &result, const char *start, const char *end, STIL::STILField field)
+{
+    if ((end > start) && (*(end - 1) != '\n'))
+        return false;
+
+    const char *tag;
+    switch (field)
+    {
+    case STIL::all:
+        result.append(start, end);
+        return true;
+    case STIL::name:    tag = NAME_STR; break;
+    case STIL::author:  tag = AUTHOR_STR; break;
+    case STIL::title:   tag = TITLE_STR; break;
+    case STIL::artist:  tag = ARTIST_STR; break;
+    case STIL::comment: tag = COMMENT_STR; break;
+    default: return false;
+    }
+
+    const char *found = search(start, end, tag);
+    if (found == nullptr)
+        return false;
+
+    const char *next = end;
+    for (const char *other : { NAME_STR, AUTHOR_STR, TITLE_STR, ARTIST_STR, COMMENT_STR })
+    {
+        const char *pos = search(found + 1, end, other);
+        if ((pos != nullptr) && (pos < next))
+            next = pos;
+    }
+
+    result.append(found, next);
+    return true;
+}
+
+}
+
+stilIndex::stilIndex() :
+    m_map(nullptr),
+    m_size(0),
+    m_stil{ nullptr, 0 },
+    m_bugs{ nullptr, 0 },
+    m_keys(nullptr),
+    m_text(nullptr) {}
+
+stilIndex::~stilIndex()
+{
+    close();
+}
+
+void stilIndex::close()
+{
+#ifdef HAVE_SYS_MMAN_H
+    if (m_map != nullptr)
+        munmap(const_cast<uint8_t*>(m_map), m_size);
+#endif
+    m_map = nullptr;
+    m_size = 0;
+    m_stil = { nullptr, 0 };
+    m_bugs = { nullptr, 0 };
+    m_keys = nullptr;
+    m_text = nullptr;
+}
+
+const stilIndex::entry_t *stilIndex::find(const table_t &table, const std::string &key, uint32_t tune) const
+{
+    const char *keys = m_keys;
+    auto compare = [keys, &key](const entry_t &e) { return key.compare(0, std::string::npos, keys + e.key, e.keyLength); };
+
+    const entry_t *end = table.entries + table.count;
+    const entry_t *entry = std::lower_bound(table.entries, end, tune,
+        [&compare](const entry_t &e, uint32_t t) { const int c = compare(e); return (c > 0) || ((c == 0) && (e.tune < t)); });
+    if ((entry == end) || (compare(*entry) != 0) || (entry->tune != tune))
+        return nullptr;
+    return entry;
+}
+
+// Same selection as the STIL library's getField
+bool stilIndex::getField(const table_t &table, const char *entry, int tuneNo,
+                         STIL::STILField field, std::string &result) const
+{
+    result.clear();
+    if (m_map == nullptr)
+        return false;
+
+    const std::string key = toLower(entry);
+    const entry_t *whole = find(table, key, 0);
+    if (whole == nullptr)
+        return false;
+
+    // Skip the path
+    const char *end = m_text + whole->offset + whole->length;
+    const char *start = static_cast<const char*>(memchr(m_text + whole->offset, '\n', whole->length)) + 1;
+    if (start == end)
+        return false;
+
+    if (!whole->multi)
+    {
+        // A leading comment is global to the file
+        if (search(start, end, COMMENT_STR) == start)
+        {
+            const char *fields = nullptr;
+            for (const char *tag : { NAME_STR, AUTHOR_STR, TITLE_STR, ARTIST_STR })
+            {
+                if ((fields = search(start, end, tag)) != nullptr)
+                    break;
+            }
+
+            if ((tuneNo == 0) && ((field == STIL::all) || ((field == STIL::comment) && (fields == nullptr))))
+            {
+                result.assign(start, end);
+                return true;
+            }
+            if ((tuneNo == 0) && (field == STIL::comment))
+            {
+                result.assign(start, fields);
+                return true;
+            }
+            if ((tuneNo == 1) && (fields != nullptr))
+                return getOneField(result, fields, end, field);
+            return false;
+        }
+
+        if ((field == STIL::all) && ((tuneNo == 0) || (tuneNo == 1)))
+        {
+            result.assign(start, end);
+            return true;
+        }
+        if (tuneNo <= 1)
+            return getOneField(result, start, end, field);
+        return false;
+    }
+
+    if (tuneNo == 0)
+    {
+        switch (field)
+        {
+        case STIL::all:
+            result.assign(start, end);
+            return true;
+        case STIL::comment:
+            return whole->head && getOneField(result, start, start + whole->head, STIL::comment);
+        default:
+            return false;
+        }
+    }
+
+    const entry_t *section = find(table, key, tuneNo);
+    if (section == nullptr)
+        return false;
+
+    const char *text = m_text + section->offset;
+    return getOneField(result, text, text + section->length, field);
+}
+
+bool stilIndex::getEntry(const char *entry, int tuneNo, STIL::STILField field, std::string &result) const
+{
+    // Directories only have a global comment
+    const size_t length = strlen(entry);
+    if ((length == 0) || (entry[length - 1] == '/'))
+        return false;
+
+    return getField(m_stil, entry, tuneNo, field, result);
+}
+
+bool stilIndex::getGlobalComment(const char *entry, std::string &result) const
+{
+    result.clear();
+    const char *slash = strrchr(entry, '/');
+    if ((m_map == nullptr) || (slash == nullptr))
+        return false;
+
+    const entry_t *dir = find(m_stil, toLower(std::string(entry, slash + 1)), 0);
+    if (dir == nullptr)
+        return false;
+
+    // Skip the path
+    const char *end = m_text + dir->offset + dir->length;
+    const char *start = static_cast<const char*>(memchr(m_text + dir->offset, '\n', dir->length)) + 1;
+    result.assign(start, end);
+    return !result.empty();
+}
+
+bool stilIndex::getBug(const char *entry, int tuneNo, std::string &result) const
+{
+    return getField(m_bugs, entry, tuneNo, STIL::all, result);
+}
+
+#ifdef HAVE_SYS_MMAN_H
+
+bool stilIndex::open(const char *hvscBase)
+{
+    close();
+
+    m_stilFile.assign(hvscBase).append(PATH_TO_STIL);
+    m_bugFile.assign(hvscBase).append(PATH_TO_BUGLIST);
+
+    header_t expected;
+    memset(&expected, 0, sizeof(expected));
+
+    struct stat st;
+    if (stat(m_stilFile.c_str(), &st) < 0)
+        return false;
+    expected.stilSize = st.st_size;
+    expected.stilTime = st.st_mtime;
+
+    if (stat(m_bugFile.c_str(), &st) == 0)
+    {
+        expected.bugSize = st.st_size;
+        expected.bugTime = st.st_mtime;
+    }
+
+    std::string indexFile;
+    try
+    {
+        indexFile = utils::getCacheFile("stil", m_stilFile.c_str());
+    }
+    catch (utils::error const &e)
+    {
+        return false;
+    }
+
+    if (map(indexFile, expected))
+        return true;
+
+    return build(indexFile, expected) && map(indexFile, expected);
+}
+
+bool stilIndex::map(const std::string &indexFile, const header_t &expected)
+{
+    const int fd = ::open(indexFile.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    void *map = MAP_FAILED;
+    if ((fstat(fd, &st) == 0) && (st.st_size >= (off_t)sizeof(header_t)))
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    m_map  = static_cast<const uint8_t*>(map);
+    m_size = st.st_size;
+
+    // Reject stale or foreign indexes
+    const header_t *header = reinterpret_cast<const header_t*>(m_map);
+    if ((memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+        || (header->version != INDEX_VERSION)
+        || (header->stilSize != expected.stilSize)
+        || (header->stilTime != expected.stilTime)
+        || (header->bugSize != expected.bugSize)
+        || (header->bugTime != expected.bugTime)
+        || (m_size != sizeof(header_t)
+                      + ((size_t)header->stilCount + header->bugCount) * sizeof(entry_t)
+                      + header->keysSize + header->textSize))
+    {
+        close();
+        return false;
+    }
+
+    m_stil.entries = reinterpret_cast<const entry_t*>(m_map + sizeof(header_t));
+    m_stil.count   = header->stilCount;
+    m_bugs.entries = m_stil.entries + m_stil.count;
+    m_bugs.count   = header->bugCount;
+    m_keys         = reinterpret_cast<const char*>(m_bugs.entries + m_bugs.count);
+    m_text         = m_keys + header->keysSize;
+
+    // Everything must point inside the pools
+    for (const entry_t *e = m_stil.entries; e != m_bugs.entries + m_bugs.count; e++)
+    {
+        if (((uint64_t)e->key + e->keyLength > header->keysSize)
+            || ((uint64_t)e->offset + e->length > header->textSize)
+            || (e->head > e->length)
+            || ((e->tune == 0) && (memchr(m_text + e->offset, '\n', e->length) == nullptr)))
+        {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool stilIndex::build(const std::string &indexFile, const header_t &expected)
+{
+    std::string text;
+    if (!readFile(m_stilFile, text))
+        return false;
+
+    header_t header = expected;
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+
+    std::vector<item_t> stil;
+    scan(text, true, stil);
+
+    std::vector<item_t> bugs;
+    if (expected.bugSize && readFile(m_bugFile, text))
+        scan(text, false, bugs);
+
+    // Sort for binary search, keeping the first of any duplicates
+    std::string keys;
+    std::string texts;
+    std::vector<entry_t> entries;
+    for (std::vector<item_t> *items : { &stil, &bugs })
+    {
+        std::stable_sort(items->begin(), items->end(),
+            [](const item_t &a, const item_t &b) { return (a.key < b.key) || ((a.key == b.key) && (a.tune < b.tune)); });
+        items->erase(std::unique(items->begin(), items->end(),
+            [](const item_t &a, const item_t &b) { return (a.key == b.key) && (a.tune == b.tune); }),
+            items->end());
+
+        const item_t *previous = nullptr;
+        for (const item_t &item : *items)
+        {
+            // Sections share the key of their entry
+            if ((previous == nullptr) || (previous->key != item.key))
+                keys.append(item.key);
+            previous = &item;
+
+            entries.push_back({ (uint32_t)(keys.length() - item.key.length()), (uint32_t)item.key.length(),
+                                item.tune, (uint32_t)texts.length(), (uint32_t)item.text.length(),
+                                item.multi, item.head });
+            texts.append(item.text);
+        }
+    }
+    header.stilCount = stil.size();
+    header.bugCount  = bugs.size();
+    header.keysSize  = keys.length();
+    header.textSize  = texts.length();
+
+    // Write to a private file and move it in place, so that
+    // concurrent lookups never map a partial index
+    const std::string tmpFile = indexFile + '.' + std::to_string(getpid());
+    {
+        std::ofstream out(tmpFile, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(entry_t));
+        out.write(keys.data(), keys.length());
+        out.write(texts.data(), texts.length());
+        out.close();
+        if (out.fail())
+        {
+            unlink(tmpFile.c_str());
+            return false;
+        }
+    }
+
+    if (rename(tmpFile.c_str(), indexFile.c_str()) < 0)
+    {
+        unlink(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+#else
+
+bool stilIndex::open(const char*) { return false; }
+
+#endif // HAVE_SYS_MMAN_H
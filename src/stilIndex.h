@@ -0,0 +1,97 @@
+/*
+ * This file is part of sidplayfp, a console SID player.
+ *
+ * Copyright 2026 Leandro Nini
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef STILINDEX_H
+#define STILINDEX_H
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <stilview/stil.h>
+
+/*
+ * Index of the STIL.txt and BUGlist.txt entries of an HVSC tree.
+ *
+ * Holds the text of each entry, and of each tune section of the
+ * multi-tune ones, keyed by HVSC path and tune number, so a single
+ * lookup doesn't have to parse the whole files. The index is stored
+ * in the cache directory, rebuilt when the size or modification time
+ * of either file change, and memory mapped read only.
+ *
+ * Lookups select tunes and fields the same way the STIL library does.
+ */
+class stilIndex
+{
+private:
+    struct header_t;
+    struct entry_t;
+
+    struct table_t
+    {
+        const entry_t* entries;
+        uint32_t       count;
+    };
+
+    const uint8_t*  m_map;
+    size_t          m_size;
+
+    table_t         m_stil;
+    table_t         m_bugs;
+    const char*     m_keys;
+    const char*     m_text;
+
+    std::string     m_stilFile;
+    std::string     m_bugFile;
+
+private:
+    bool map(const std::string &indexFile, const header_t &expected);
+    bool build(const std::string &indexFile, const header_t &expected);
+    const entry_t *find(const table_t &table, const std::string &key, uint32_t tune) const;
+    bool getField(const table_t &table, const char *entry, int tuneNo,
+                  STIL::STILField field, std::string &result) const;
+
+public:
+    stilIndex();
+    ~stilIndex();
+
+    /**
+     * Map the index for the given HVSC base directory,
+     * building it first if missing or stale.
+     */
+    bool open(const char *hvscBase);
+    void close();
+
+    /**
+     * Counterparts of STIL::getEntry, getGlobalComment and getBug
+     * for an HVSC relative path.
+     *
+     * @return false if there is nothing to show
+     */
+    bool getEntry(const char *entry, int tuneNo, STIL::STILField field, std::string &result) const;
+    bool getGlobalComment(const char *entry, std::string &result) const;
+    bool getBug(const char *entry, int tuneNo, std::string &result) const;
+};
+
+#endif
@@ -32,6 +32,8 @@
 
 #include <codeConvert.h>
 
+#include "stilIndex.h"
+
 #include <stilview/stil.h>
 
 #include "sidcxx11.h"
@@ -343,7 +345,13 @@ int main(int argc, char **argv)
         }
     }
 
-    if (myStil.setBaseDir(hvscLoc) != true)
+    // A single lookup is served from the index, without
+    // having the library parse the whole documents
+    stilIndex index;
+    const bool indexed = (!interactive) && (!demo) && (!showVersion)
+        && (entryStr != nullptr) && index.open(hvscLoc);
+
+    if (!indexed && (myStil.setBaseDir(hvscLoc) != true))
     {
         cerr << "STIL error #" << myStil.getError() << ": " << myStil.getErrorStr() << endl;
         exit(1);
@@ -352,6 +360,7 @@ int main(int argc, char **argv)
     if ((!interactive) && (!demo))
     {
         // Pure command-line version.
+        std::string section, entry, bug;
 
         if (showVersion)
         {
@@ -363,7 +372,10 @@ int main(int argc, char **argv)
         }
 
         if (showSection) {
-            sectionPtr = myStil.getGlobalComment(entryStr);
+            if (indexed)
+                sectionPtr = index.getGlobalComment(entryStr, section) ? section.c_str() : nullptr;
+            else
+                sectionPtr = myStil.getGlobalComment(entryStr);
         }
         else
         {
@@ -372,7 +384,10 @@ int main(int argc, char **argv)
 
         if (showEntry)
         {
-            entryPtr = myStil.getEntry(entryStr, tuneNo, field);
+            if (indexed)
+                entryPtr = index.getEntry(entryStr, tuneNo, field, entry) ? entry.c_str() : nullptr;
+            else
+                entryPtr = myStil.getEntry(entryStr, tuneNo, field);
         }
         else {
             entryPtr = nullptr;
@@ -380,7 +395,10 @@ int main(int argc, char **argv)
 
         if (showBug)
         {
-            bugPtr = myStil.getBug(entryStr, tuneNo);
+            if (indexed)
+                bugPtr = index.getBug(entryStr, tuneNo, bug) ? bug.c_str() : nullptr;
+            else
+                bugPtr = myStil.getBug(entryStr, tuneNo);
         }
         else {
             bugPtr = nullptr;
@@ -67,8 +67,16 @@ SID_STRING utils::getDataPath() { return getPath(); }
 
 SID_STRING utils::getConfigPath() { return getPath(); }
 
+SID_STRING utils::getCachePath() { return getPath(); }
+
 #else
 
+#include <cstdint>
+#include <cstdio>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
 SID_STRING utils::getPath(const char* id, const char* def)
 {
     SID_STRING returnPath;
@@ -91,4 +99,31 @@ SID_STRING utils::getDataPath() { return getPath("XDG_DATA_HOME", "/.local/share
 
 SID_STRING utils::getConfigPath() { return getPath("XDG_CONFIG_HOME", "/.config"); }
 
+SID_STRING utils::getCachePath() { return getPath("XDG_CACHE_HOME", "/.cache"); }
+
+std::string utils::getCacheFile(const char* name, const char* source)
+{
+    // One file per source, named after its canonical path
+    char *path = realpath(source, nullptr);
+    const std::string key(path ? path : source);
+    free(path);
+
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char c : key)
+    {
+        hash ^= (uint8_t)c;
+        hash *= 0x100000001b3ULL;
+    }
+
+    std::string cacheFile(getCachePath());
+    mkdir(cacheFile.c_str(), 0755);
+    cacheFile.append("/sidplayfp");
+    mkdir(cacheFile.c_str(), 0755);
+
+    char suffix[24];
+    snprintf(suffix, sizeof(suffix), "-%016llx.idx", (unsigned long long)hash);
+    return cacheFile.append("/").append(name).append(suffix);
+}
+
 #endif
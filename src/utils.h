@@ -42,8 +42,16 @@ public:
 
     static SID_STRING getConfigPath();
 
+    static SID_STRING getCachePath();
+
 #ifdef _WIN32
     static SID_STRING getExecPath();
+#else
+    /**
+     * Get the path of a cache file derived from the given source file,
+     * creating the cache directory if needed.
+     */
+    static std::string getCacheFile(const char* name, const char* source);
 #endif
 };
 